@@ -1,7 +1,31 @@
+#define _GNU_SOURCE
+#include <arpa/inet.h>
 #include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
 
 //Keeping all the following struct/function definitions here for ease of readability instead of keeping them in a header file.
 
@@ -9,6 +33,7 @@
 typedef struct RBtreeNode {
 	char *word;
 	char color; //r or b. Anything else is invalid.
+	int count; //Number of times the word has been inserted.
 	struct RBtreeNode *parent;
 	struct RBtreeNode *left;
 	struct RBtreeNode *right;
@@ -127,11 +152,103 @@ node* getUncle(node *child) {
 	
 }
 
-//Mallocs memory for a new node and automatically colors it red.
-node* makeNode(char *word, node *parent) {
-	node *newNode = malloc(sizeof(node));
+/*
+ * Bump arena. Nodes and words are carved out of large chunks one after another and are never freed individually. Resetting the arena makes all of
+ * its chunks reusable at once in O(1), which lets a mode throw away a whole tree without walking it.
+ */
+
+#define ARENA_CHUNK_SIZE (1 << 20)
+
+typedef struct ArenaChunk {
+	struct ArenaChunk *next;
+	size_t size;
+	size_t used;
+	char bytes[];
+} arenaChunk;
+
+typedef struct BumpArena {
+	arenaChunk *first;
+	arenaChunk *current;
+} bumpArena;
+
+//Sets up an empty bump arena.
+void bumpInit(bumpArena *a) {
+	a->first = NULL;
+	a->current = NULL;
+}
+
+//Returns "size" bytes from arena "a", aligned for any node or word.
+void* bumpAlloc(bumpArena *a, size_t size) {
+	arenaChunk *chunk = NULL;
+
+	size = (size + 7) & ~(size_t) 7;
+
+	//Move on to the next chunk if this one is full, reusing chunks left over from before the last reset where possible.
+	while (a->current == NULL || a->current->used + size > a->current->size) {
+		if (a->current != NULL && a->current->next != NULL) {
+			a->current = a->current->next;
+			a->current->used = 0;
+			continue;
+		}
+
+		chunk = malloc(sizeof(arenaChunk) + (size > ARENA_CHUNK_SIZE ? size : ARENA_CHUNK_SIZE));
+		chunk->next = NULL;
+		chunk->size = size > ARENA_CHUNK_SIZE ? size : ARENA_CHUNK_SIZE;
+		chunk->used = 0;
+
+		if (a->current == NULL) {
+			a->first = chunk;
+		} else {
+			a->current->next = chunk;
+		}
+
+		a->current = chunk;
+	}
+
+	a->current->used += size;
+
+	return a->current->bytes + a->current->used - size;
+}
+
+//Copies "length" bytes at "word" into arena "a" as a NUL-terminated string and returns the copy.
+char* bumpCopy(bumpArena *a, char *word, int length) {
+	char *copy = bumpAlloc(a, length + 1);
+
+	memcpy(copy, word, length);
+	copy[length] = '\0';
+
+	return copy;
+}
+
+//Forgets everything allocated from arena "a" in O(1). The chunks are kept and reused by later allocations.
+void bumpReset(bumpArena *a) {
+	a->current = a->first;
+
+	if (a->current != NULL) {
+		a->current->used = 0;
+	}
+}
+
+//Frees every chunk of arena "a".
+void recycleBump(bumpArena *a) {
+	arenaChunk *chunk = a->first
+                  ,*next = NULL;
+
+	while (chunk != NULL) {
+		next = chunk->next;
+		free(chunk);
+		chunk = next;
+	}
+
+	bumpInit(a);
+}
+
+//Makes a new node in arena "a", or with malloc if "a" is NULL, and automatically colors it red.
+node* makeNodeIn(char *word, node *parent, bumpArena *a) {
+	node *newNode = a == NULL ? malloc(sizeof(node)) : bumpAlloc(a, sizeof(node));
 	setWord(newNode, word);
 	setColor(newNode, 'r');
+	newNode->count = 1;
 	setParent(newNode, parent);
 	setLeftChild(newNode, NULL);
 	setRightChild(newNode, NULL);
@@ -139,6 +256,11 @@ node* makeNode(char *word, node *parent) {
 	return newNode;
 }
 
+//Mallocs memory for a new node and automatically colors it red.
+node* makeNode(char *word, node *parent) {
+	return makeNodeIn(word, parent, NULL);
+}
+
 //Frees memory associated with a given node "n".
 void recycleNode(node *n) {
 	if (n != NULL) {
@@ -217,8 +339,12 @@ node* rightRotate(node *root, node *n) {
 	return root;
 }
 
-//Inserts a new node into the tree, or creates a new root node if one does not exist.
-node* insert(node *root, char *word) {
+/*
+ * Inserts a new node into the tree, or creates a new root node if one does not exist. If the word is already in the tree its count is incremented
+ * instead. Either way, the node holding the word is stored in "result" if it isn't NULL, so callers can tell whether "word" was used.
+ * New nodes come from arena "a", or from malloc if it is NULL.
+ */
+node* insertNodeIn(node *root, char *word, node **result, bumpArena *a) {
 	node *ptr = root
             ,*parent = NULL
             ,*uncle = NULL
@@ -228,7 +354,14 @@ node* insert(node *root, char *word) {
 
 	//Peform a standard binary search tree insertion.
 	if (root == NULL) {
-		root = makeNode(word, NULL);
+		root = makeNodeIn(word, NULL, a);
+		setColor(root, 'b');
+
+		if (result != NULL) {
+			*result = root;
+		}
+
+		return root;
 	}
 
 	//Ditto.
@@ -238,6 +371,12 @@ node* insert(node *root, char *word) {
 		cmp = strcmp(word, getWord(ptr));
 
 		if (cmp == 0) {
+			ptr->count++;
+
+			if (result != NULL) {
+				*result = ptr;
+			}
+
 			return root;
 		} else if (cmp < 0) {
 			ptr = getLeftChild(ptr);
@@ -247,15 +386,22 @@ node* insert(node *root, char *word) {
 	}
 
 	if (cmp < 0) {
-		setLeftChild(parent, makeNode(word, parent));
+		setLeftChild(parent, makeNodeIn(word, parent, a));
 		ptr = getLeftChild(parent);
 	} else {
-		setRightChild(parent, makeNode(word, parent));
+		setRightChild(parent, makeNodeIn(word, parent, a));
 		ptr = getRightChild(parent);
 	}
 
+	//Rotations below move nodes around but never replace them, so this stays valid.
+	if (result != NULL) {
+		*result = ptr;
+	}
+
 	//Checks the red-black tree for validity and restructures it if this tree has violated any red-black tree proprerties.
-	while (ptr != root && getColor(parent) == 'r') {
+	//"parent" has to be re-read on every pass, since moving up the tree or rotating changes which node it is.
+	while (ptr != root && getColor(getParent(ptr)) == 'r') {
+		parent = getParent(ptr);
 		uncle = getUncle(ptr);
 		grandparent = getGrandparent(ptr);
 
@@ -269,6 +415,7 @@ node* insert(node *root, char *word) {
 				 if (ptr == getRightChild(parent)) {
 					ptr = parent;
 					root = leftRotate(root, ptr);
+					parent = getParent(ptr);
 				}
 
 				setColor(parent, 'b');
@@ -285,6 +432,7 @@ node* insert(node *root, char *word) {
 				if (ptr == getLeftChild(parent)) {
 					ptr = parent;
 					root = rightRotate(root, ptr);
+					parent = getParent(ptr);
 				}
 
 				setColor(parent, 'b');
@@ -299,6 +447,512 @@ node* insert(node *root, char *word) {
 	return root;
 }
 
+//Like insertNodeIn, with new nodes from malloc.
+node* insertNode(node *root, char *word, node **result) {
+	return insertNodeIn(root, word, result, NULL);
+}
+
+//Inserts a new node into the tree, or creates a new root node if one does not exist.
+node* insert(node *root, char *word) {
+	return insertNode(root, word, NULL);
+}
+
+//Returns the node holding "word" in the tree with root node "root", or NULL if it is not there.
+node* findNode(node *root, char *word) {
+	int cmp = 0;
+
+	while (root != NULL) {
+		cmp = strcmp(word, getWord(root));
+
+		if (cmp == 0) {
+			return root;
+		}
+
+		root = cmp < 0 ? getLeftChild(root) : getRightChild(root);
+	}
+
+	return NULL;
+}
+
+//Returns the leftmost node of the tree with root node "root".
+node* getMinimum(node *root) {
+	while (getLeftChild(root) != NULL) {
+		root = getLeftChild(root);
+	}
+
+	return root;
+}
+
+//Returns the node after "n" in sorted order, or NULL if "n" is the last node. Together with getMinimum this walks a tree without recursion.
+node* getSuccessor(node *n) {
+	node *parent = NULL;
+
+	if (getRightChild(n) != NULL) {
+		return getMinimum(getRightChild(n));
+	}
+
+	parent = getParent(n);
+
+	while (parent != NULL && n == getRightChild(parent)) {
+		n = parent;
+		parent = getParent(n);
+	}
+
+	return parent;
+}
+
+//Puts node "v" in the place of node "u" under u's parent and returns the root of the tree afterwards. "v" may be NULL.
+node* transplant(node *root, node *u, node *v) {
+	if (getParent(u) == NULL) {
+		root = v;
+	} else if (u == getLeftChild(getParent(u))) {
+		setLeftChild(getParent(u), v);
+	} else {
+		setRightChild(getParent(u), v);
+	}
+
+	setParent(v, getParent(u));
+
+	return root;
+}
+
+/*
+ * Restores the red-black properties after a black node was removed from above "n", and returns the root of the tree afterwards.
+ * "n" is often a NULL leaf, which can't say who its parent is, so "parent" is passed alongside it. NULL leaves count as black.
+ */
+node* removeFixup(node *root, node *n, node *parent) {
+	node *sibling = NULL;
+
+	while (n != root && getColor(n) != 'r') {
+		if (n == getLeftChild(parent)) {
+			sibling = getRightChild(parent);
+
+			if (getColor(sibling) == 'r') {
+				setColor(sibling, 'b');
+				setColor(parent, 'r');
+				root = leftRotate(root, parent);
+				sibling = getRightChild(parent);
+			}
+
+			if (getColor(getLeftChild(sibling)) != 'r' && getColor(getRightChild(sibling)) != 'r') {
+				setColor(sibling, 'r');
+				n = parent;
+				parent = getParent(n);
+			} else {
+				if (getColor(getRightChild(sibling)) != 'r') {
+					setColor(getLeftChild(sibling), 'b');
+					setColor(sibling, 'r');
+					root = rightRotate(root, sibling);
+					sibling = getRightChild(parent);
+				}
+
+				setColor(sibling, getColor(parent));
+				setColor(parent, 'b');
+				setColor(getRightChild(sibling), 'b');
+				root = leftRotate(root, parent);
+				n = root;
+			}
+		} else {
+			sibling = getLeftChild(parent);
+
+			if (getColor(sibling) == 'r') {
+				setColor(sibling, 'b');
+				setColor(parent, 'r');
+				root = rightRotate(root, parent);
+				sibling = getLeftChild(parent);
+			}
+
+			if (getColor(getLeftChild(sibling)) != 'r' && getColor(getRightChild(sibling)) != 'r') {
+				setColor(sibling, 'r');
+				n = parent;
+				parent = getParent(n);
+			} else {
+				if (getColor(getLeftChild(sibling)) != 'r') {
+					setColor(getRightChild(sibling), 'b');
+					setColor(sibling, 'r');
+					root = leftRotate(root, sibling);
+					sibling = getLeftChild(parent);
+				}
+
+				setColor(sibling, getColor(parent));
+				setColor(parent, 'b');
+				setColor(getLeftChild(sibling), 'b');
+				root = rightRotate(root, parent);
+				n = root;
+			}
+		}
+	}
+
+	setColor(n, 'b');
+
+	return root;
+}
+
+//Unlinks node "n" from the tree and returns the root of the tree afterwards. "n" itself is not freed, and no other node is moved into its memory.
+node* removeNode(node *root, node *n) {
+	node *successor = n
+            ,*child = NULL
+            ,*childParent = NULL;
+	char removedColor = getColor(n);
+
+	if (getLeftChild(n) == NULL) {
+		child = getRightChild(n);
+		childParent = getParent(n);
+		root = transplant(root, n, child);
+	} else if (getRightChild(n) == NULL) {
+		child = getLeftChild(n);
+		childParent = getParent(n);
+		root = transplant(root, n, child);
+	} else {
+		//Two children: the in-order successor takes n's place and n's color.
+		successor = getMinimum(getRightChild(n));
+		removedColor = getColor(successor);
+		child = getRightChild(successor);
+
+		if (getParent(successor) == n) {
+			childParent = successor;
+		} else {
+			childParent = getParent(successor);
+			root = transplant(root, successor, child);
+			setRightChild(successor, getRightChild(n));
+			setParent(getRightChild(successor), successor);
+		}
+
+		root = transplant(root, n, successor);
+		setLeftChild(successor, getLeftChild(n));
+		setParent(getLeftChild(successor), successor);
+		setColor(successor, getColor(n));
+	}
+
+	if (removedColor == 'b') {
+		root = removeFixup(root, child, childParent);
+	}
+
+	return root;
+}
+
+/*
+ * Typed ordered sets. DEFINE_RBSET(name, keyType, valueType, compare) generates a red-black tree with keys of "keyType" and a "valueType" payload
+ * in every node, ordered by "compare(a, b)", which returns less than, equal to or greater than zero like strcmp. Everything is generated as static
+ * inline functions, so the comparison is inlined into the descent rather than called through a pointer. Integer keys, for example, only need
+ * DEFINE_RBSET(intSet, int, int, COMPARE_NUMBERS). The generated functions follow the node functions above:
+ *
+ *	nameInsert(root, key, &result, arena)	inserts "key" if it is missing and returns the new root; a new node's value is zeroed
+ *	nameFind(root, key)			returns the node holding "key", or NULL
+ *	nameMinimum(root), nameSuccessor(n)	walk the set in order
+ *	nameRecycle(root)			frees a set whose nodes came from malloc (a NULL arena)
+ */
+
+#define COMPARE_NUMBERS(a, b) (((a) > (b)) - ((a) < (b)))
+
+#define DEFINE_RBSET(name, keyType, valueType, compare) \
+typedef struct name##Node { \
+	keyType key; \
+	valueType value; \
+	char color; /*r or b.*/ \
+	struct name##Node *parent; \
+	struct name##Node *left; \
+	struct name##Node *right; \
+} name##Node; \
+\
+/*NULL leaves count as black.*/ \
+static inline char name##Color(name##Node *n) { \
+	return n == NULL ? 'b' : n->color; \
+} \
+\
+static inline name##Node* name##LeftRotate(name##Node *root, name##Node *n) { \
+	name##Node *m = n->right; \
+\
+	n->right = m->left; \
+\
+	if (m->left != NULL) { \
+		m->left->parent = n; \
+	} \
+\
+	m->parent = n->parent; \
+\
+	if (n->parent == NULL) { \
+		root = m; \
+	} else if (n == n->parent->left) { \
+		n->parent->left = m; \
+	} else { \
+		n->parent->right = m; \
+	} \
+\
+	m->left = n; \
+	n->parent = m; \
+\
+	return root; \
+} \
+\
+static inline name##Node* name##RightRotate(name##Node *root, name##Node *n) { \
+	name##Node *m = n->left; \
+\
+	n->left = m->right; \
+\
+	if (m->right != NULL) { \
+		m->right->parent = n; \
+	} \
+\
+	m->parent = n->parent; \
+\
+	if (n->parent == NULL) { \
+		root = m; \
+	} else if (n == n->parent->right) { \
+		n->parent->right = m; \
+	} else { \
+		n->parent->left = m; \
+	} \
+\
+	m->right = n; \
+	n->parent = m; \
+\
+	return root; \
+} \
+\
+static inline name##Node* name##Insert(name##Node *root, keyType key, name##Node **result, bumpArena *a) { \
+	name##Node *ptr = root \
+                  ,*parent = NULL \
+                  ,*uncle = NULL \
+                  ,*grandparent = NULL; \
+	int cmp = 0; \
+\
+	while (ptr != NULL) { \
+		parent = ptr; \
+		cmp = compare(key, ptr->key); \
+\
+		if (cmp == 0) { \
+			if (result != NULL) { \
+				*result = ptr; \
+			} \
+\
+			return root; \
+		} \
+\
+		ptr = cmp < 0 ? ptr->left : ptr->right; \
+	} \
+\
+	ptr = a == NULL ? malloc(sizeof(name##Node)) : bumpAlloc(a, sizeof(name##Node)); \
+	memset(&ptr->value, 0, sizeof(valueType)); \
+	ptr->key = key; \
+	ptr->color = 'r'; \
+	ptr->parent = parent; \
+	ptr->left = NULL; \
+	ptr->right = NULL; \
+\
+	if (parent == NULL) { \
+		root = ptr; \
+	} else if (cmp < 0) { \
+		parent->left = ptr; \
+	} else { \
+		parent->right = ptr; \
+	} \
+\
+	if (result != NULL) { \
+		*result = ptr; \
+	} \
+\
+	while (ptr != root && ptr->parent->color == 'r') { \
+		parent = ptr->parent; \
+		grandparent = parent->parent; \
+\
+		if (parent == grandparent->left) { \
+			uncle = grandparent->right; \
+\
+			if (name##Color(uncle) == 'r') { \
+				parent->color = 'b'; \
+				uncle->color = 'b'; \
+				grandparent->color = 'r'; \
+				ptr = grandparent; \
+			} else { \
+				if (ptr == parent->right) { \
+					ptr = parent; \
+					root = name##LeftRotate(root, ptr); \
+					parent = ptr->parent; \
+				} \
+\
+				parent->color = 'b'; \
+				grandparent->color = 'r'; \
+				root = name##RightRotate(root, grandparent); \
+			} \
+		} else { \
+			uncle = grandparent->left; \
+\
+			if (name##Color(uncle) == 'r') { \
+				parent->color = 'b'; \
+				uncle->color = 'b'; \
+				grandparent->color = 'r'; \
+				ptr = grandparent; \
+			} else { \
+				if (ptr == parent->left) { \
+					ptr = parent; \
+					root = name##RightRotate(root, ptr); \
+					parent = ptr->parent; \
+				} \
+\
+				parent->color = 'b'; \
+				grandparent->color = 'r'; \
+				root = name##LeftRotate(root, grandparent); \
+			} \
+		} \
+	} \
+\
+	root->color = 'b'; \
+\
+	return root; \
+} \
+\
+static inline name##Node* name##Find(name##Node *root, keyType key) { \
+	int cmp = 0; \
+\
+	while (root != NULL && (cmp = compare(key, root->key)) != 0) { \
+		root = cmp < 0 ? root->left : root->right; \
+	} \
+\
+	return root; \
+} \
+\
+static inline name##Node* name##Minimum(name##Node *root) { \
+	while (root != NULL && root->left != NULL) { \
+		root = root->left; \
+	} \
+\
+	return root; \
+} \
+\
+static inline name##Node* name##Successor(name##Node *n) { \
+	if (n->right != NULL) { \
+		return name##Minimum(n->right); \
+	} \
+\
+	while (n->parent != NULL && n == n->parent->right) { \
+		n = n->parent; \
+	} \
+\
+	return n->parent; \
+} \
+\
+static inline void name##Recycle(name##Node *root) { \
+	if (root != NULL) { \
+		name##Recycle(root->left); \
+		name##Recycle(root->right); \
+		free(root); \
+	} \
+}
+
+/*
+ * Prefix-keyed word set. Each word's first eight bytes are packed big-endian into an integer, so comparing two keys is one integer comparison
+ * unless the words share all eight bytes, and the order is still exactly strcmp's.
+ */
+
+typedef struct PrefixKey {
+	uint64_t prefix;
+	char *word;
+} prefixKey;
+
+//Packs the first eight of the "length" bytes at "word" into a prefix, padding short words with zeroes.
+uint64_t packPrefix(const char *word, int length) {
+	uint64_t prefix = 0;
+	int i = 0;
+
+	for (i = 0; i < 8; i++) {
+		prefix = prefix << 8 | (i < length ? (unsigned char) word[i] : 0);
+	}
+
+	return prefix;
+}
+
+//Compares two prefix keys in strcmp order.
+static inline int comparePrefixKeys(prefixKey a, prefixKey b) {
+	if (a.prefix != b.prefix) {
+		return a.prefix < b.prefix ? -1 : 1;
+	}
+
+	//Equal prefixes with a zero last byte mean both words ended inside the prefix, so they are the same word.
+	if ((a.prefix & 0xff) == 0) {
+		return 0;
+	}
+
+	return strcmp(a.word + 8, b.word + 8);
+}
+
+DEFINE_RBSET(prefixSet, prefixKey, int, comparePrefixKeys)
+
+//The set and arena a prefixVisitor inserts into.
+typedef struct PrefixTree {
+	prefixSetNode *root;
+	bumpArena arena;
+	int count;
+} prefixTree;
+
+//Word visitor which inserts the word into the prefixTree pointed to by "context", copying it into the arena only if it is new.
+void prefixVisitor(char *word, int wordLength, void *context) {
+	prefixTree *tree = context;
+	prefixSetNode *n = NULL;
+	prefixKey key;
+	char saved = word[wordLength];
+
+	word[wordLength] = '\0';
+	key.prefix = packPrefix(word, wordLength);
+	key.word = word;
+	tree->root = prefixSetInsert(tree->root, key, &n, &tree->arena);
+	word[wordLength] = saved;
+
+	if (n->value++ == 0) {
+		n->key.word = bumpCopy(&tree->arena, word, wordLength);
+		tree->count++;
+	}
+}
+
+//Returns a malloc'd array of the words of "tree" in sorted order. The words still belong to the tree's arena.
+char** flattenPrefixTree(prefixTree *tree) {
+	char **words = malloc((tree->count + 1) * sizeof(char *));
+	prefixSetNode *n = NULL;
+	int i = 0;
+
+	for (n = prefixSetMinimum(tree->root); n != NULL; n = prefixSetSuccessor(n)) {
+		words[i++] = n->key.word;
+	}
+
+	return words;
+}
+
+//Calls "visit" on every maximal run of letters in the first "length" characters of "text". The word is not NUL-terminated; "wordLength" gives its length.
+void forEachWord(char *text, size_t length, void (*visit)(char *word, int wordLength, void *context), void *context) {
+	size_t i = 0;
+	int wordLength = 0;
+
+	while (i < length) {
+		while (i < length && isalpha(text[i])) {
+			wordLength++;
+			i++;
+		}
+
+		if (wordLength != 0) {
+			visit(&text[i - wordLength], wordLength, context);
+		}
+
+		wordLength = 0;
+		i++;
+	}
+}
+
+//Word visitor which copies the word and inserts it into the tree whose root is pointed to by "context".
+void insertVisitor(char *word, int wordLength, void *context) {
+	node **root = context;
+	char *newWord = malloc(wordLength + 1);
+	node *inserted = NULL;
+
+	memcpy(newWord, word, wordLength);
+	newWord[wordLength] = '\0';
+	*root = insertNode(*root, newWord, &inserted);
+
+	//The copy isn't needed if the word was already in the tree.
+	if (getWord(inserted) != newWord) {
+		free(newWord);
+	}
+}
+
 //Prints the contents of a tree with root node "root"  in sorted order.
 void printTree(node *root) {
 	if (root == NULL) {
@@ -310,48 +964,5686 @@ void printTree(node *root) {
 	printTree(getRightChild(root));
 }
 
+//Holds a growable array of words.
+typedef struct WordList {
+	char **words;
+	int count;
+	int capacity;
+} wordList;
 
-int main(int argc, char **argv) {
-	node *root = NULL;
-	char *newWord = NULL;
-	int inputLength = 0
-           ,wordLength = 0
+//Word visitor which copies the word onto the end of the wordList pointed to by "context".
+void collectVisitor(char *word, int wordLength, void *context) {
+	wordList *list = context;
+
+	if (list->count == list->capacity) {
+		list->capacity = list->capacity == 0 ? 64 : list->capacity * 2;
+		list->words = realloc(list->words, list->capacity * sizeof(char *));
+	}
+
+	list->words[list->count++] = strndup(word, wordLength);
+}
+
+//qsort comparator for an array of strings.
+int compareWords(const void *a, const void *b) {
+	return strcmp(*(char * const *) a, *(char * const *) b);
+}
+
+//Frees a wordList and every word in it.
+void recycleWordList(wordList *list) {
+	int i = 0;
+
+	for (i = 0; i < list->count; i++) {
+		free(list->words[i]);
+	}
+
+	free(list->words);
+	list->words = NULL;
+	list->count = 0;
+	list->capacity = 0;
+}
+
+/*
+ * Looks up "count" words in the tree with root node "root" and sets found[i] to 1 or 0 for each. One lookup spends most of its time waiting on the
+ * cache miss for the next node and then for that node's word, so up to BATCH_WIDTH lookups are kept in flight at once. Each lookup is a small state
+ * machine which prefetches what it needs next and then yields to the next lookup, so the misses overlap instead of happening one after another.
+ */
+
+#define BATCH_WIDTH 16
+
+typedef struct LookupState {
+	node *ptr;
+	int index; //Which word this lookup is for, or -1 if the slot is free.
+	char wordLoaded; //0 while waiting for the node itself, 1 while waiting for the node's word.
+} lookupState;
+
+void containsBatch(node *root, char **words, int count, char *found) {
+	lookupState slots[BATCH_WIDTH];
+	int next = 0
+           ,active = 0
+           ,cmp = 0
            ,i = 0;
 
-	//Should be exactly 2 arguments. All other cases are errors which will be caught by this conditional.	
-	if (argc != 2) {
-		printf("Invalid number of arguments (%d) provided.\n", argc - 1);
-		return -1;
+	for (i = 0; i < BATCH_WIDTH; i++) {
+		slots[i].index = -1;
 	}
-	
-//	printf("---START DEBUG INFO---\n");
 
-	//Get length of input argument/length of all valid substrings plus delimiters.
-	inputLength = strlen(argv[1]);
+	do {
+		active = 0;
 
-	//Iterate over the input argument.
-	while (i < inputLength) {
-		while (isalpha(argv[1][i]) && i < inputLength) {
-			wordLength++;
-			i++;
-		}
+		for (i = 0; i < BATCH_WIDTH; i++) {
+			lookupState *slot = &slots[i];
+
+			//Start a new lookup in any free slot.
+			if (slot->index < 0) {
+				if (next >= count) {
+					continue;
+				}
 
-		if (wordLength != 0) { 
-			newWord = malloc(wordLength + 1);	
-			memcpy(newWord, &argv[1][i - wordLength], wordLength);
-			root = insert(root, newWord);
-			newWord = NULL;
+				slot->index = next++;
+				slot->ptr = root;
+				slot->wordLoaded = 0;
+				__builtin_prefetch(slot->ptr);
+				active++;
+				continue;
+			}
+
+			active++;
+
+			if (slot->ptr == NULL) {
+				found[slot->index] = 0;
+				slot->index = -1;
+			} else if (!slot->wordLoaded) {
+				__builtin_prefetch(slot->ptr->word);
+				slot->wordLoaded = 1;
+			} else {
+				cmp = strcmp(words[slot->index], slot->ptr->word);
+
+				if (cmp == 0) {
+					found[slot->index] = 1;
+					slot->index = -1;
+				} else {
+					slot->ptr = cmp < 0 ? slot->ptr->left : slot->ptr->right;
+					slot->wordLoaded = 0;
+
+					if (slot->ptr != NULL) {
+						__builtin_prefetch(slot->ptr);
+					}
+				}
+			}
 		}
+	} while (active > 0);
+}
 
-		wordLength = 0;
-		i++;
-	} 
+//Returns a 64-bit hash of "length" bytes at "bytes" which differs for each "seed" (FNV-1a followed by a final mix so the low bits are usable alone).
+uint64_t hashSeeded(const char *bytes, size_t length, uint64_t seed) {
+	uint64_t h = 0xcbf29ce484222325ULL ^ (seed * 0x9e3779b97f4a7c15ULL);
+	size_t i = 0;
 
-//	printf("---END DEBUG INFO---\n");
+	for (i = 0; i < length; i++) {
+		h ^= (unsigned char) bytes[i];
+		h *= 0x100000001b3ULL;
+	}
 
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
 
-	printTree(root);
-	recycleTree(root);
+	return h;
+}
+
+//Returns a 64-bit hash of "length" bytes at "bytes".
+uint64_t hashBytes(const char *bytes, size_t length) {
+	return hashSeeded(bytes, length, 0);
+}
+
+/*
+ * Cuckoo filter. Each word is reduced to a 16-bit fingerprint which lives in one of two buckets, the second found from the first and the fingerprint
+ * alone, so entries can be moved between their buckets and removed again without knowing the word. A bucket is four fingerprints packed in one
+ * 64-bit word and is probed for a fingerprint in a few instructions by comparing all four lanes at once.
+ */
+
+#define CUCKOO_SLOTS 4
+#define CUCKOO_MAX_KICKS 500
+#define CUCKOO_LANES 0x0001000100010001ULL
+#define CUCKOO_HIGH_BITS 0x8000800080008000ULL
+
+typedef struct CuckooFilter {
+	uint64_t *buckets; //A fingerprint of 0 marks an empty slot.
+	uint64_t mask; //The number of buckets minus one. The number of buckets is always a power of two.
+	uint64_t count;
+} cuckooFilter;
+
+//Sets up an empty filter with room for at least "capacity" fingerprints.
+void cuckooInit(cuckooFilter *f, uint64_t capacity) {
+	uint64_t buckets = 1;
+
+	while (buckets * CUCKOO_SLOTS < capacity) {
+		buckets *= 2;
+	}
+
+	f->buckets = calloc(buckets, sizeof(uint64_t));
+	f->mask = buckets - 1;
+	f->count = 0;
+}
+
+//Frees the buckets of filter "f".
+void cuckooFree(cuckooFilter *f) {
+	free(f->buckets);
+	f->buckets = NULL;
+}
+
+//Returns the fingerprint for a word with hash "h". Fingerprints are never 0, since 0 marks an empty slot.
+uint16_t cuckooFingerprint(uint64_t h) {
+	uint16_t fingerprint = h >> 48;
+
+	return fingerprint == 0 ? 1 : fingerprint;
+}
+
+//Returns the other bucket that fingerprint "fingerprint" in bucket "index" may live in.
+uint64_t cuckooAlternate(cuckooFilter *f, uint64_t index, uint16_t fingerprint) {
+	return (index ^ (fingerprint * 0x5bd1e995ULL)) & f->mask;
+}
+
+//Returns nonzero if any of the four lanes of "bucket" holds "fingerprint".
+uint64_t bucketHas(uint64_t bucket, uint16_t fingerprint) {
+	uint64_t lanes = bucket ^ (fingerprint * CUCKOO_LANES);
+
+	//Standard zero-lane test: only a lane that was exactly zero can borrow into its own high bit without having had that bit set already.
+	return (lanes - CUCKOO_LANES) & ~lanes & CUCKOO_HIGH_BITS;
+}
+
+//Replaces one lane of "bucket" holding "from" with "to". Returns 1 if a lane was replaced, or 0 if no lane held "from".
+int bucketSwap(uint64_t *bucket, uint16_t from, uint16_t to) {
+	int lane = 0;
+
+	if (!bucketHas(*bucket, from)) {
+		return 0;
+	}
+
+	for (lane = 0; lane < CUCKOO_SLOTS; lane++) {
+		if ((uint16_t) (*bucket >> (lane * 16)) == from) {
+			*bucket &= ~(0xffffULL << (lane * 16));
+			*bucket |= (uint64_t) to << (lane * 16);
+			return 1;
+		}
+	}
 
 	return 0;
 }
+
+//Returns 1 if a word with hash "h" may be in filter "f", or 0 if it definitely is not.
+int cuckooContains(cuckooFilter *f, uint64_t h) {
+	uint16_t fingerprint = cuckooFingerprint(h);
+	uint64_t index = h & f->mask;
+
+	return bucketHas(f->buckets[index], fingerprint) || bucketHas(f->buckets[cuckooAlternate(f, index, fingerprint)], fingerprint);
+}
+
+//Adds a word with hash "h" to filter "f". Returns 1 on success, or 0 if the filter is too full, in which case it must be rebuilt larger.
+int cuckooAdd(cuckooFilter *f, uint64_t h) {
+	uint16_t fingerprint = cuckooFingerprint(h)
+                ,victim = 0;
+	uint64_t index = h & f->mask;
+	int kicks = 0
+           ,lane = 0;
+
+	if (bucketSwap(&f->buckets[index], 0, fingerprint)) {
+		f->count++;
+		return 1;
+	}
+
+	index = cuckooAlternate(f, index, fingerprint);
+
+	//Both buckets are full, so evict a random fingerprint to its other bucket, and so on until one of them finds room.
+	for (kicks = 0; kicks < CUCKOO_MAX_KICKS; kicks++) {
+		if (bucketSwap(&f->buckets[index], 0, fingerprint)) {
+			f->count++;
+			return 1;
+		}
+
+		lane = random() % CUCKOO_SLOTS;
+		victim = f->buckets[index] >> (lane * 16);
+		f->buckets[index] &= ~(0xffffULL << (lane * 16));
+		f->buckets[index] |= (uint64_t) fingerprint << (lane * 16);
+		fingerprint = victim;
+		index = cuckooAlternate(f, index, fingerprint);
+	}
+
+	return 0;
+}
+
+//Removes one copy of a word with hash "h" from filter "f". The word must have been added before.
+void cuckooRemove(cuckooFilter *f, uint64_t h) {
+	uint16_t fingerprint = cuckooFingerprint(h);
+	uint64_t index = h & f->mask;
+
+	if (bucketSwap(&f->buckets[index], fingerprint, 0) || bucketSwap(&f->buckets[cuckooAlternate(f, index, fingerprint)], fingerprint, 0)) {
+		f->count--;
+	}
+}
+
+//Adds every word in the tree with root node "root" to filter "f". Returns 1 on success, or 0 if the filter filled up.
+int cuckooAddTree(cuckooFilter *f, node *root) {
+	char *word = getWord(root);
+
+	if (root == NULL) {
+		return 1;
+	}
+
+	return cuckooAdd(f, hashBytes(word, strlen(word))) && cuckooAddTree(f, getLeftChild(root)) && cuckooAddTree(f, getRightChild(root));
+}
+
+//Replaces filter "f" with one at least twice as big which holds every word in the tree with root node "root".
+void cuckooRebuild(cuckooFilter *f, node *root) {
+	uint64_t capacity = (f->mask + 1) * CUCKOO_SLOTS;
+
+	do {
+		cuckooFree(f);
+		capacity *= 2;
+		cuckooInit(f, capacity);
+	} while (!cuckooAddTree(f, root));
+}
+
+/*
+ * Incremental compaction for trees whose nodes and words live in bump arenas. Deleting from such a tree leaves holes that are never reused, so once
+ * most of the current arena is dead, new allocations switch to the other arena and the live nodes are moved across a few at a time, in sorted order,
+ * so neighbours in the tree end up next to each other in memory. A moved node leaves behind a forwarding stub (NULL word, parent pointing to the new
+ * copy) for any outside references. When every node has moved and the owner has resolved its references, the old arena is freed in one go.
+ */
+
+#define COMPACT_STEP 64 //Most nodes moved per step, which bounds the pause.
+#define COMPACT_MIN 4096 //Arenas with fewer nodes than this aren't worth compacting.
+
+typedef struct Compactor {
+	bumpArena spaces[2];
+	int current; //Index of the space new nodes are allocated from.
+	int moving; //1 while live nodes are being moved out of the other space.
+	int draining; //1 once they all have, until the owner releases the other space.
+	char *cursor; //Word of the last node moved, or NULL before the first.
+	long allocated; //Nodes allocated from the current space.
+	long live; //Nodes in the tree.
+} compactor;
+
+//Sets up a compactor with two empty spaces.
+void compactorInit(compactor *c) {
+	bumpInit(&c->spaces[0]);
+	bumpInit(&c->spaces[1]);
+	c->current = 0;
+	c->moving = 0;
+	c->draining = 0;
+	c->cursor = NULL;
+	c->allocated = 0;
+	c->live = 0;
+}
+
+//Frees both spaces of a compactor, and with them every node and word of its tree.
+void recycleCompactor(compactor *c) {
+	recycleBump(&c->spaces[0]);
+	recycleBump(&c->spaces[1]);
+	compactorInit(c);
+}
+
+//Returns 1 if "p" was allocated from arena "a", or 0 otherwise.
+int bumpOwns(bumpArena *a, void *p) {
+	arenaChunk *chunk = NULL;
+
+	for (chunk = a->first; chunk != NULL; chunk = chunk->next) {
+		if ((char *) p >= chunk->bytes && (char *) p < chunk->bytes + chunk->size) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+//Inserts a copy of the "length" bytes at "word" into the tree with root node "root", allocating from the current space. Returns the new root.
+node* compactInsert(compactor *c, node *root, char *word, int length, node **result) {
+	node *inserted = NULL;
+
+	root = insertNodeIn(root, bumpCopy(&c->spaces[c->current], word, length), &inserted, &c->spaces[c->current]);
+
+	if (inserted->count == 1) {
+		c->allocated++;
+		c->live++;
+	}
+
+	if (result != NULL) {
+		*result = inserted;
+	}
+
+	return root;
+}
+
+//Removes node "n" from the tree with root node "root" and returns the new root. Its memory becomes a hole until the next compaction.
+node* compactRemove(compactor *c, node *root, node *n) {
+	c->live--;
+
+	return removeNode(root, n);
+}
+
+//Follows forwarding stubs from "n" to where the node lives now.
+node* compactResolve(node *n) {
+	while (n != NULL && getWord(n) == NULL) {
+		n = getParent(n);
+	}
+
+	return n;
+}
+
+//Returns the node with the smallest word greater than "word" in the tree with root node "root", or the minimum if "word" is NULL.
+node* compactNext(node *root, char *word) {
+	node *next = NULL;
+
+	while (root != NULL) {
+		if (word == NULL || strcmp(getWord(root), word) > 0) {
+			next = root;
+			root = getLeftChild(root);
+		} else {
+			root = getRightChild(root);
+		}
+	}
+
+	return next;
+}
+
+//Moves node "n" into the current space, relinking its parent and children, and returns the root of the tree afterwards.
+node* compactMove(compactor *c, node *root, node *n) {
+	node *m = bumpAlloc(&c->spaces[c->current], sizeof(node));
+
+	*m = *n;
+	setWord(m, bumpCopy(&c->spaces[c->current], getWord(n), strlen(getWord(n))));
+
+	if (getParent(n) == NULL) {
+		root = m;
+	} else if (getLeftChild(getParent(n)) == n) {
+		setLeftChild(getParent(n), m);
+	} else {
+		setRightChild(getParent(n), m);
+	}
+
+	if (getLeftChild(n) != NULL) {
+		setParent(getLeftChild(n), m);
+	}
+
+	if (getRightChild(n) != NULL) {
+		setParent(getRightChild(n), m);
+	}
+
+	setWord(n, NULL);
+	setParent(n, m);
+	c->allocated++;
+
+	return root;
+}
+
+/*
+ * Does one bounded step of compaction on the tree with root node "root" and returns the new root. Starts a pass if the current space is mostly
+ * holes. Once every live node has moved, "draining" is set and nothing more happens until the owner calls compactRelease.
+ */
+node* compactStep(compactor *c, node *root) {
+	node *n = NULL;
+	int moved = 0;
+
+	if (!c->moving && !c->draining) {
+		if (c->allocated < COMPACT_MIN || c->allocated < 2 * c->live) {
+			return root;
+		}
+
+		c->current ^= 1;
+		c->moving = 1;
+		c->cursor = NULL;
+		c->allocated = 0;
+	}
+
+	while (c->moving && moved < COMPACT_STEP) {
+		n = compactNext(root, c->cursor);
+
+		if (n == NULL) {
+			c->moving = 0;
+			c->draining = 1;
+		} else if (bumpOwns(&c->spaces[c->current], n)) {
+			//Inserted since the pass started, so it is already in the right space.
+			c->cursor = getWord(n);
+		} else {
+			root = compactMove(c, root, n);
+			c->cursor = getWord(compactResolve(n));
+			moved++;
+		}
+	}
+
+	return root;
+}
+
+//Frees the space compacted out of, once nothing outside the tree points into it any more.
+void compactRelease(compactor *c) {
+	recycleBump(&c->spaces[c->current ^ 1]);
+	c->draining = 0;
+}
+
+/*
+ * Sliding-window mode keeps the vocabulary of only the most recent "size" words. Each word's node counts how many times it occurs in the window, and
+ * when the count of a word leaving the window reaches zero the word is deleted from both the tree and the cuckoo filter. The filter answers
+ * membership queries against the final window: most words that aren't in it are reported without descending the tree at all. Sliding itself
+ * checks the filter only to choose between looking a word up and inserting it straight away, so either way each word costs one descent.
+ */
+
+typedef struct SlidingWindow {
+	node *root;
+	node **ring; //The node of each word in the window. The oldest is at "next" once the window is full.
+	int size;
+	int next;
+	int filled;
+	int sweep; //Ring entries already resolved since compaction last finished moving nodes.
+	cuckooFilter filter;
+	compactor nodes;
+} slidingWindow;
+
+//Word visitor which slides the slidingWindow pointed to by "context" forward by one word.
+void windowVisitor(char *word, int wordLength, void *context) {
+	slidingWindow *window = context;
+	node *n = NULL;
+	uint64_t h = hashBytes(word, wordLength);
+	char saved = word[wordLength];
+	int i = 0;
+
+	//Drop the oldest word first so the window never holds more than "size" words.
+	if (window->filled == window->size) {
+		n = compactResolve(window->ring[window->next]);
+		n->count--;
+
+		if (n->count == 0) {
+			cuckooRemove(&window->filter, hashBytes(getWord(n), strlen(getWord(n))));
+			window->root = compactRemove(&window->nodes, window->root, n);
+		}
+
+		n = NULL;
+	} else {
+		window->filled++;
+	}
+
+	if (cuckooContains(&window->filter, h)) {
+		word[wordLength] = '\0';
+		n = findNode(window->root, word);
+		word[wordLength] = saved;
+	}
+
+	if (n != NULL) {
+		n->count++;
+	} else {
+		window->root = compactInsert(&window->nodes, window->root, word, wordLength, &n);
+
+		if ((window->filter.count + 1) * 10 > (window->filter.mask + 1) * CUCKOO_SLOTS * 9 || !cuckooAdd(&window->filter, h)) {
+			cuckooRebuild(&window->filter, window->root);
+		}
+	}
+
+	window->ring[window->next] = n;
+	window->next = (window->next + 1) % window->size;
+
+	//Expiring words leave holes behind, so compact a little on every word. The ring still points at stubs until it has been swept.
+	if (window->nodes.draining) {
+		for (i = 0; i < COMPACT_STEP && window->sweep < window->filled; i++, window->sweep++) {
+			window->ring[window->sweep] = compactResolve(window->ring[window->sweep]);
+		}
+
+		if (window->sweep == window->filled) {
+			compactRelease(&window->nodes);
+			window->sweep = 0;
+		}
+	} else {
+		window->root = compactStep(&window->nodes, window->root);
+	}
+}
+
+//Prints each of the "count" words in "words" which is not in the slidingWindow "window". Words the filter rules out never touch the tree.
+void windowCheck(slidingWindow *window, char **words, int count) {
+	int i = 0;
+
+	for (i = 0; i < count; i++) {
+		if (!cuckooContains(&window->filter, hashBytes(words[i], strlen(words[i]))) || findNode(window->root, words[i]) == NULL) {
+			printf("%s\n", words[i]);
+		}
+	}
+}
+
+//Returns the number of nodes in a tree with root node "root".
+int countNodes(node *root) {
+	if (root == NULL) {
+		return 0;
+	}
+
+	return countNodes(getLeftChild(root)) + 1 + countNodes(getRightChild(root));
+}
+
+//Copies the words of a tree with root node "root" into "words" in sorted order, starting at index "i". Returns the index after the last word copied.
+int flattenTree(node *root, char **words, int i) {
+	if (root == NULL) {
+		return i;
+	}
+
+	i = flattenTree(getLeftChild(root), words, i);
+	words[i++] = getWord(root);
+	return flattenTree(getRightChild(root), words, i);
+}
+
+//Describes one slice of the sorted words for a formatting thread, and holds the buffer it formatted them into.
+typedef struct FormatJob {
+	char **words;
+	int first;
+	int last; //Exclusive.
+	char *buffer;
+	size_t length;
+} formatJob;
+
+//Thread body which formats the words in one slice into a newly malloc'd buffer, one word per line.
+void* formatRange(void *arg) {
+	formatJob *job = arg;
+	size_t wordLength = 0;
+	char *ptr = NULL;
+	int i = 0;
+
+	//Size the buffer first so it only has to be allocated once.
+	job->length = 0;
+	for (i = job->first; i < job->last; i++) {
+		job->length += strlen(job->words[i]) + 1;
+	}
+
+	job->buffer = malloc(job->length + 1);
+	ptr = job->buffer;
+
+	for (i = job->first; i < job->last; i++) {
+		wordLength = strlen(job->words[i]);
+		memcpy(ptr, job->words[i], wordLength);
+		ptr += wordLength;
+		*ptr++ = '\n';
+	}
+
+	return NULL;
+}
+
+//Writes all of "buffer" to "fd" at "offset", or at the current position if "offset" is negative. Returns 0 on success or -1 on error.
+int writeAll(int fd, char *buffer, size_t length, off_t offset) {
+	ssize_t written = 0;
+
+	while (length > 0) {
+		if (offset >= 0) {
+			written = pwrite(fd, buffer, length, offset);
+		} else {
+			written = write(fd, buffer, length);
+		}
+
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			return -1;
+		}
+
+		buffer += written;
+		length -= written;
+
+		if (offset >= 0) {
+			offset += written;
+		}
+	}
+
+	return 0;
+}
+
+//Maps the file "path" read-only and stores its size in "size". Returns the mapping, or NULL if the file is missing or empty.
+void* mapFile(char *path, size_t *size) {
+	struct stat info;
+	void *map = NULL;
+	int fd = open(path, O_RDONLY);
+
+	if (fd < 0) {
+		return NULL;
+	}
+
+	if (fstat(fd, &info) != 0 || info.st_size == 0) {
+		close(fd);
+		return NULL;
+	}
+
+	*size = info.st_size;
+	map = mmap(NULL, *size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	return map == MAP_FAILED ? NULL : map;
+}
+
+//Writes "length" bytes at "bytes" to the new file "path". Returns 0 on success or -1 on error.
+int writeFile(char *path, void *bytes, size_t length) {
+	int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644)
+           ,result = 0;
+
+	if (fd < 0) {
+		return -1;
+	}
+
+	result = writeAll(fd, bytes, length, -1);
+
+	if (close(fd) != 0) {
+		result = -1;
+	}
+
+	return result;
+}
+
+/*
+ * Starts "body" on a new thread with "arg", storing the thread in "thread". If no thread can be started, "body" is run here instead and "thread"
+ * is set to this thread, which joinStarted knows not to join.
+ */
+void startOrRun(pthread_t *thread, void* (*body)(void *arg), void *arg) {
+	if (pthread_create(thread, NULL, body, arg) != 0) {
+		body(arg);
+		*thread = pthread_self();
+	}
+}
+
+//Joins "thread" if startOrRun really started it.
+void joinStarted(pthread_t thread) {
+	if (!pthread_equal(thread, pthread_self())) {
+		pthread_join(thread, NULL);
+	}
+}
+
+/*
+ * Prints "count" sorted words to "fd" using "threads" formatting threads. The words are split into equal rank ranges, each thread formats its range
+ * into its own buffer, and the buffers are then written back in order with pwrite at offsets computed from the buffer lengths.
+ * Pipes and terminals can't pwrite, so for those the buffers are written in order with plain write instead.
+ */
+int printParallel(char **words, int count, int threads, int fd) {
+	formatJob *jobs = NULL;
+	pthread_t *workers = NULL;
+	off_t base = 0
+             ,offset = 0;
+	int i = 0
+           ,result = 0;
+
+	if (threads < 1) {
+		threads = 1;
+	}
+
+	if (threads > count && count > 0) {
+		threads = count;
+	}
+
+	jobs = malloc(threads * sizeof(formatJob));
+	workers = malloc(threads * sizeof(pthread_t));
+
+	for (i = 0; i < threads; i++) {
+		jobs[i].words = words;
+		jobs[i].first = (int) ((long long) count * i / threads);
+		jobs[i].last = (int) ((long long) count * (i + 1) / threads);
+		jobs[i].buffer = NULL;
+		jobs[i].length = 0;
+		startOrRun(&workers[i], formatRange, &jobs[i]);
+	}
+
+	for (i = 0; i < threads; i++) {
+		joinStarted(workers[i]);
+	}
+
+	//A negative base means the descriptor isn't seekable.
+	base = lseek(fd, 0, SEEK_CUR);
+	offset = base;
+
+	for (i = 0; i < threads; i++) {
+		if (result == 0 && writeAll(fd, jobs[i].buffer, jobs[i].length, offset) != 0) {
+			result = -1;
+		}
+
+		if (offset >= 0) {
+			offset += jobs[i].length;
+		}
+
+		free(jobs[i].buffer);
+	}
+
+	//pwrite doesn't move the file position, so move it past the output for anything written after this.
+	if (base >= 0) {
+		lseek(fd, offset, SEEK_SET);
+	}
+
+	free(jobs);
+	free(workers);
+
+	return result;
+}
+
+//Thread body which measures the formatted length of one formatJob's words without formatting them.
+void* measureRange(void *arg) {
+	formatJob *job = arg;
+	int i = 0;
+
+	job->length = 0;
+	for (i = job->first; i < job->last; i++) {
+		job->length += strlen(job->words[i]) + 1;
+	}
+
+	return NULL;
+}
+
+//Thread body which copies one formatJob's words, one per line, to its "buffer", which already points at the right place in the output.
+void* copyRange(void *arg) {
+	formatJob *job = arg;
+	size_t wordLength = 0;
+	char *ptr = job->buffer;
+	int i = 0;
+
+	for (i = job->first; i < job->last; i++) {
+		wordLength = strlen(job->words[i]);
+		memcpy(ptr, job->words[i], wordLength);
+		ptr += wordLength;
+		*ptr++ = '\n';
+	}
+
+	return NULL;
+}
+
+/*
+ * Splits "count" sorted words into equal rank ranges for "threads" threads and measures each range's formatted length on its own thread. Returns
+ * the malloc'd jobs, storing how many there are in "threads" and their total length in "total".
+ */
+formatJob* measureJobs(char **words, int count, int *threads, size_t *total) {
+	formatJob *jobs = NULL;
+	pthread_t *workers = NULL;
+	int i = 0;
+
+	if (*threads < 1) {
+		*threads = 1;
+	}
+
+	if (*threads > count && count > 0) {
+		*threads = count;
+	}
+
+	jobs = malloc(*threads * sizeof(formatJob));
+	workers = malloc(*threads * sizeof(pthread_t));
+
+	for (i = 0; i < *threads; i++) {
+		jobs[i].words = words;
+		jobs[i].first = (int) ((long long) count * i / *threads);
+		jobs[i].last = (int) ((long long) count * (i + 1) / *threads);
+		jobs[i].buffer = NULL;
+		startOrRun(&workers[i], measureRange, &jobs[i]);
+	}
+
+	*total = 0;
+	for (i = 0; i < *threads; i++) {
+		joinStarted(workers[i]);
+		*total += jobs[i].length;
+	}
+
+	free(workers);
+
+	return jobs;
+}
+
+//Copies the words of "threads" measured jobs one after another into "out", each job on its own thread.
+void copyJobs(formatJob *jobs, int threads, char *out) {
+	pthread_t *workers = malloc(threads * sizeof(pthread_t));
+	int i = 0;
+
+	for (i = 0; i < threads; i++) {
+		jobs[i].buffer = out;
+		out += jobs[i].length;
+		startOrRun(&workers[i], copyRange, &jobs[i]);
+	}
+
+	for (i = 0; i < threads; i++) {
+		joinStarted(workers[i]);
+	}
+
+	free(workers);
+}
+
+//Returns 1 if "fd" is a regular file, which printMapped can write to, or 0 otherwise.
+int isRegularFile(int fd) {
+	struct stat info;
+
+	return fstat(fd, &info) == 0 && S_ISREG(info.st_mode);
+}
+
+//Returns 1 if "fd" is a pipe, which printSpliced can write to, or 0 otherwise.
+int isPipe(int fd) {
+	struct stat info;
+
+	return fstat(fd, &info) == 0 && S_ISFIFO(info.st_mode);
+}
+
+/*
+ * Prints "count" sorted words to the regular file "fd" through a shared mapping instead of write. The threads first measure their ranges, which
+ * gives the exact size of the output and each range's offset. The file is then extended to fit, and each thread copies its words straight into the
+ * mapping. Returns 0 on success, or 1 if "fd" can't be mapped, in which case nothing has been written.
+ */
+int printMapped(char **words, int count, int threads, int fd) {
+	formatJob *jobs = NULL;
+	struct stat info;
+	char *map = NULL
+            ,path[64];
+	off_t start = 0
+             ,base = 0;
+	size_t total = 0;
+	int mapped = 0;
+
+	if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+		return 1;
+	}
+
+	//Files opened for appending are written at their end, wherever the file position happens to be.
+	start = (fcntl(fd, F_GETFL) & O_APPEND) ? info.st_size : lseek(fd, 0, SEEK_CUR);
+
+	if (start < 0) {
+		return 1;
+	}
+
+	jobs = measureJobs(words, count, &threads, &total);
+
+	//Mappings have to start on a page boundary, so map from the one before "start".
+	base = start & ~(off_t) (sysconf(_SC_PAGESIZE) - 1);
+
+	if (total > 0) {
+		//Shared writable mappings need a descriptor open for reading as well, which redirected output usually isn't, so reopen the file.
+		snprintf(path, sizeof(path), "/proc/self/fd/%d", fd);
+		mapped = open(path, O_RDWR);
+
+		//Only ever extend the file. Bytes past the output are left alone, the same as write would leave them.
+		if (mapped < 0 || (start + (off_t) total > info.st_size && ftruncate(mapped, start + total) != 0)) {
+			if (mapped >= 0) {
+				close(mapped);
+			}
+
+			free(jobs);
+			return 1;
+		}
+
+		map = mmap(NULL, start + total - base, PROT_READ | PROT_WRITE, MAP_SHARED, mapped, base);
+		close(mapped);
+
+		if (map == MAP_FAILED) {
+			if (start + (off_t) total > info.st_size) {
+				ftruncate(fd, info.st_size);
+			}
+
+			free(jobs);
+			return 1;
+		}
+
+		copyJobs(jobs, threads, map + (start - base));
+		munmap(map, start + total - base);
+	}
+
+	lseek(fd, start + total, SEEK_SET);
+	free(jobs);
+
+	return 0;
+}
+
+/*
+ * Prints "count" sorted words to the pipe "fd" with vmsplice, so the kernel takes the pages of the output buffer instead of copying them. The buffer
+ * is page-aligned and never touched again once spliced, which lets whole pages be gifted to the pipe. Returns 0 on success, -1 on error, or 1 if
+ * "fd" isn't a pipe, in which case nothing has been written.
+ */
+int printSpliced(char **words, int count, int threads, int fd) {
+	formatJob *jobs = NULL;
+	struct stat info;
+	struct iovec chunk;
+	char *buffer = NULL;
+	size_t total = 0
+              ,size = 0
+              ,page = sysconf(_SC_PAGESIZE)
+              ,spliced = 0;
+	ssize_t length = 0;
+	int result = 0;
+
+	if (fstat(fd, &info) != 0 || !S_ISFIFO(info.st_mode)) {
+		return 1;
+	}
+
+	jobs = measureJobs(words, count, &threads, &total);
+	size = (total + page - 1) / page * page;
+
+	if (total > 0) {
+		buffer = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if (buffer == MAP_FAILED) {
+			free(jobs);
+			return 1;
+		}
+
+		copyJobs(jobs, threads, buffer);
+	}
+
+	while (spliced < total) {
+		chunk.iov_base = buffer + spliced;
+		chunk.iov_len = total - spliced;
+		length = vmsplice(fd, &chunk, 1, SPLICE_F_GIFT);
+
+		if (length < 0 && errno == EINTR) {
+			continue;
+		}
+
+		//Kernels or pipes that won't splice still get the rest of the buffer the ordinary way.
+		if (length < 0) {
+			result = errno == EPIPE ? -1 : writeAll(fd, buffer + spliced, total - spliced, -1);
+			break;
+		}
+
+		spliced += length;
+	}
+
+	//The pipe holds its own references to the spliced pages, so unmapping here doesn't pull them out from under the reader.
+	if (buffer != NULL) {
+		munmap(buffer, size);
+	}
+
+	free(jobs);
+
+	return result;
+}
+
+//Describes one output shard: the slice of sorted words it holds and the file it is written to.
+typedef struct ShardJob {
+	formatJob format;
+	char *path;
+	int result;
+} shardJob;
+
+//Thread body which formats one shard's words and writes them to the shard's file.
+void* writeShard(void *arg) {
+	shardJob *job = arg;
+	int fd = 0;
+
+	formatRange(&job->format);
+
+	fd = open(job->path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+	if (fd < 0) {
+		job->result = -1;
+	} else {
+		job->result = writeAll(fd, job->format.buffer, job->format.length, -1);
+		close(fd);
+	}
+
+	free(job->format.buffer);
+
+	return NULL;
+}
+
+/*
+ * Writes "count" sorted words into "shards" files named "prefix" followed by the shard number. The splitters are order statistics of the sorted words,
+ * so every shard holds an equal share and every word in shard i is less than every word in shard i + 1. Each shard is written by its own thread.
+ * Returns 0 on success or -1 if any shard could not be written.
+ */
+int writeShards(char **words, int count, int shards, char *prefix) {
+	shardJob *jobs = NULL;
+	pthread_t *workers = NULL;
+	int i = 0
+           ,result = 0;
+
+	jobs = malloc(shards * sizeof(shardJob));
+	workers = malloc(shards * sizeof(pthread_t));
+
+	for (i = 0; i < shards; i++) {
+		jobs[i].format.words = words;
+		jobs[i].format.first = (int) ((long long) count * i / shards);
+		jobs[i].format.last = (int) ((long long) count * (i + 1) / shards);
+		jobs[i].path = malloc(strlen(prefix) + 12);
+		sprintf(jobs[i].path, "%s%d", prefix, i);
+		jobs[i].result = 0;
+		startOrRun(&workers[i], writeShard, &jobs[i]);
+	}
+
+	for (i = 0; i < shards; i++) {
+		joinStarted(workers[i]);
+
+		if (jobs[i].result != 0) {
+			printf("Could not write shard %s.\n", jobs[i].path);
+			result = -1;
+		}
+
+		free(jobs[i].path);
+	}
+
+	free(jobs);
+	free(workers);
+
+	return result;
+}
+
+/*
+ * Stop words. A word is looked up in a perfect hash table with one probe and one string compare, and without copying or allocating anything, so
+ * common words are dropped at tokenize time before they ever reach insert. The table is hash-and-displace: keys are hashed into small buckets, and
+ * each bucket gets a seed chosen so that rehashing its keys with that seed lands every key of every bucket in a different slot.
+ */
+
+#define STOPWORD_MAX_LENGTH 32
+
+typedef struct PerfectHash {
+	const uint16_t *seeds; //One per bucket.
+	uint32_t bucketCount;
+	const char * const *table; //The key in each slot, or NULL.
+	uint32_t size;
+} perfectHash;
+
+//Returns the slot "word" would be in if it were a key of "ph".
+uint32_t perfectSlot(const perfectHash *ph, const char *word, int length) {
+	uint32_t bucket = hashSeeded(word, length, 0) % ph->bucketCount;
+
+	return hashSeeded(word, length, ph->seeds[bucket]) % ph->size;
+}
+
+//Returns 1 if the "length" bytes at "word" are a key of "ph", or 0 otherwise.
+int perfectContains(const perfectHash *ph, const char *word, int length) {
+	const char *key = ph->table[perfectSlot(ph, word, length)];
+
+	return key != NULL && strncmp(key, word, length) == 0 && key[length] == '\0';
+}
+
+//qsort_r comparator ordering bucket numbers by how many keys are in each bucket, largest first.
+int compareBucketSizes(const void *a, const void *b, void *context) {
+	uint32_t *sizes = context;
+
+	return (int) sizes[*(const uint32_t *) b] - (int) sizes[*(const uint32_t *) a];
+}
+
+/*
+ * Builds a perfect hash table of "count" distinct keys into "ph", whose seeds and table are then malloc'd. Keys are sorted into their buckets once,
+ * and buckets are placed largest first, since those are hardest to fit. The table starts at a load factor of about 0.8 and is made bigger until
+ * every bucket finds a seed. Returns 0 on success or -1 if no table could be found.
+ */
+int buildPerfectHash(perfectHash *ph, char **keys, int count) {
+	uint32_t *sizes = NULL
+                ,*starts = NULL
+                ,*members = NULL
+                ,*lengths = NULL
+                ,*order = NULL
+                ,*slots = NULL
+                ,bucket = 0
+                ,seed = 0
+                ,size = 0
+                ,i = 0
+                ,j = 0
+                ,k = 0;
+	uint16_t *seeds = NULL;
+	const char **table = NULL;
+	int attempt = 0
+           ,fits = 0;
+
+	ph->bucketCount = count / 4 + 1;
+	sizes = calloc(ph->bucketCount, sizeof(uint32_t));
+	starts = calloc(ph->bucketCount + 1, sizeof(uint32_t));
+	members = malloc((count + 1) * sizeof(uint32_t));
+	lengths = malloc((count + 1) * sizeof(uint32_t));
+	order = malloc(ph->bucketCount * sizeof(uint32_t));
+	slots = malloc((count + 1) * sizeof(uint32_t));
+
+	//Bucket every key once: count the buckets, turn the counts into starting positions, then drop each key into place.
+	for (i = 0; i < (uint32_t) count; i++) {
+		lengths[i] = strlen(keys[i]);
+		slots[i] = hashSeeded(keys[i], lengths[i], 0) % ph->bucketCount;
+		sizes[slots[i]]++;
+	}
+
+	for (i = 0; i < ph->bucketCount; i++) {
+		starts[i + 1] = starts[i] + sizes[i];
+		order[i] = i;
+	}
+
+	for (i = 0; i < (uint32_t) count; i++) {
+		members[starts[slots[i]] + --sizes[slots[i]]] = i;
+	}
+
+	for (i = 0; i < ph->bucketCount; i++) {
+		sizes[i] = starts[i + 1] - starts[i];
+	}
+
+	qsort_r(order, ph->bucketCount, sizeof(uint32_t), compareBucketSizes, sizes);
+
+	for (attempt = 0; attempt < 8 && !fits; attempt++) {
+		ph->size = count + count / 4 * (attempt + 1) + 1;
+		seeds = calloc(ph->bucketCount, sizeof(uint16_t));
+		table = calloc(ph->size, sizeof(char *));
+		ph->seeds = seeds;
+		ph->table = table;
+		fits = 1;
+
+		for (bucket = 0; bucket < ph->bucketCount && fits; bucket++) {
+			size = sizes[order[bucket]];
+
+			if (size == 0) {
+				break;
+			}
+
+			//Try seeds until every key in this bucket lands in a free slot distinct from the others'.
+			for (seed = 1; seed < 65536; seed++) {
+				for (j = 0; j < size; j++) {
+					i = members[starts[order[bucket]] + j];
+					slots[j] = hashSeeded(keys[i], lengths[i], seed) % ph->size;
+
+					for (k = 0; k < j && slots[k] != slots[j]; k++) {
+					}
+
+					if (table[slots[j]] != NULL || k < j) {
+						break;
+					}
+				}
+
+				if (j == size) {
+					break;
+				}
+			}
+
+			if (seed == 65536) {
+				fits = 0;
+				break;
+			}
+
+			seeds[order[bucket]] = seed;
+
+			for (j = 0; j < size; j++) {
+				table[slots[j]] = keys[members[starts[order[bucket]] + j]];
+			}
+		}
+
+		if (!fits) {
+			free(seeds);
+			free(table);
+		}
+	}
+
+	free(sizes);
+	free(starts);
+	free(members);
+	free(lengths);
+	free(order);
+	free(slots);
+
+	return fits ? 0 : -1;
+}
+
+//The built-in English stop words. After changing this list, regenerate the tables below with "pointersorter --emit-stopwords".
+const char *builtinStopwords[] = {
+	"a", "about", "above", "after", "again", "against", "all", "am", "an", "and", "any", "are", "as", "at", "be", "because", "been", "before",
+	"being", "below", "between", "both", "but", "by", "can", "could", "did", "do", "does", "doing", "down", "during", "each", "few", "for", "from",
+	"further", "had", "has", "have", "having", "he", "her", "here", "hers", "herself", "him", "himself", "his", "how", "i", "if", "in", "into", "is",
+	"it", "its", "itself", "just", "me", "more", "most", "my", "myself", "no", "nor", "not", "now", "of", "off", "on", "once", "only", "or",
+	"other", "our", "ours", "ourselves", "out", "over", "own", "same", "she", "should", "so", "some", "such", "than", "that", "the", "their",
+	"theirs", "them", "themselves", "then", "there", "these", "they", "this", "those", "through", "to", "too", "under", "until", "up", "very",
+	"was", "we", "were", "what", "when", "where", "which", "while", "who", "whom", "why", "will", "with", "would", "you", "your", "yours",
+	"yourself", "yourselves"
+};
+
+//Generated by "pointersorter --emit-stopwords". Do not edit by hand.
+const uint16_t builtinStopwordSeeds[32] = {
+	2, 23, 8, 1, 1, 2, 1, 9, 8, 1, 15, 22, 1, 9, 23, 2,
+	5, 2, 2, 10, 5, 32, 11, 7, 14, 21, 10, 86, 1, 21, 62, 1
+};
+
+const char * const builtinStopwordTable[158] = {
+	NULL, "what", "some", "most", "any", "they", "at", NULL,
+	"over", "do", "themselves", NULL, "because", "was", "and", NULL,
+	"own", "myself", "that", "very", NULL, "few", "until", "having",
+	"but", "from", "have", NULL, NULL, "your", "on", "if",
+	NULL, "below", "does", "no", NULL, "we", "out", "it",
+	"each", "you", NULL, "this", "yourself", "there", "between", "will",
+	"for", "with", "now", "as", "both", "a", NULL, NULL,
+	"itself", "above", "her", "them", NULL, "before", "our", NULL,
+	NULL, "other", "its", "were", "himself", NULL, "had", "is",
+	"being", "than", "more", "through", "those", "only", NULL, "then",
+	NULL, "of", NULL, "again", "how", "these", NULL, "been",
+	NULL, "his", NULL, "when", NULL, NULL, "why", "am",
+	"against", "into", "can", NULL, "doing", "be", "yourselves", "has",
+	"him", NULL, NULL, "their", "hers", "all", "whom", "nor",
+	"or", "an", "where", "by", "ours", "herself", "once", "during",
+	"are", "me", "the", "same", NULL, "too", NULL, "which",
+	"did", NULL, "who", "could", "he", "here", NULL, "just",
+	"up", "ourselves", "to", "not", NULL, "theirs", "under", "while",
+	"would", "i", "down", "off", "after", "further", "in", "about",
+	"my", "so", "such", "she", "yours", "should"
+};
+
+const perfectHash builtinStopwordHash = {builtinStopwordSeeds, 32, builtinStopwordTable, 158};
+
+//Prints C definitions of the perfect hash tables for builtinStopwords, to be pasted over the generated tables above. Returns 0 on success.
+int emitStopwordTables(void) {
+	perfectHash ph;
+	int count = sizeof(builtinStopwords) / sizeof(builtinStopwords[0])
+           ,i = 0;
+
+	if (buildPerfectHash(&ph, (char **) builtinStopwords, count) != 0) {
+		printf("Could not build a perfect hash of the built-in stop words.\n");
+		return -1;
+	}
+
+	printf("//Generated by \"pointersorter --emit-stopwords\". Do not edit by hand.\n");
+	printf("const uint16_t builtinStopwordSeeds[%u] = {", ph.bucketCount);
+
+	for (i = 0; i < (int) ph.bucketCount; i++) {
+		printf("%s%s%u", i == 0 ? "" : ",", i % 16 == 0 ? "\n\t" : " ", ph.seeds[i]);
+	}
+
+	printf("\n};\n\nconst char * const builtinStopwordTable[%u] = {", ph.size);
+
+	for (i = 0; i < (int) ph.size; i++) {
+		if (ph.table[i] == NULL) {
+			printf("%s%sNULL", i == 0 ? "" : ",", i % 8 == 0 ? "\n\t" : " ");
+		} else {
+			printf("%s%s\"%s\"", i == 0 ? "" : ",", i % 8 == 0 ? "\n\t" : " ", ph.table[i]);
+		}
+	}
+
+	printf("\n};\n\nconst perfectHash builtinStopwordHash = {builtinStopwordSeeds, %u, builtinStopwordTable, %u};\n", ph.bucketCount, ph.size);
+
+	free((void *) ph.seeds);
+	free((void *) ph.table);
+
+	return 0;
+}
+
+//Builds a perfect hash of the words in the file "path" into "ph". Keys are lowercased and kept for as long as the program runs. Returns 0 on success.
+int loadStopwords(perfectHash *ph, char *path) {
+	wordList list = {NULL, 0, 0};
+	struct stat info;
+	size_t size = 0;
+	char *text = mapFile(path, &size)
+            ,*copy = NULL;
+	int unique = 0
+           ,i = 0
+           ,j = 0;
+
+	//mapFile won't map an empty file, but an empty list of stop words is still a list.
+	if (text == NULL && (stat(path, &info) != 0 || info.st_size != 0)) {
+		return -1;
+	}
+
+	if (text != NULL) {
+		copy = strndup(text, size);
+		munmap(text, size);
+		forEachWord(copy, size, collectVisitor, &list);
+		free(copy);
+	}
+
+	for (i = 0; i < list.count; i++) {
+		//stopwordVisitor lowercases into a fixed buffer, so longer stop words could never match.
+		if (strlen(list.words[i]) >= STOPWORD_MAX_LENGTH) {
+			printf("Stop word %s is longer than %d letters.\n", list.words[i], STOPWORD_MAX_LENGTH - 1);
+			recycleWordList(&list);
+			return -1;
+		}
+
+		for (j = 0; list.words[i][j] != '\0'; j++) {
+			list.words[i][j] = tolower((unsigned char) list.words[i][j]);
+		}
+	}
+
+	//Keys must be distinct, so sort them and drop repeats. An empty file leaves no list to sort.
+	if (list.count > 0) {
+		qsort(list.words, list.count, sizeof(char *), compareWords);
+	}
+
+	for (i = 0; i < list.count; i++) {
+		if (unique == 0 || strcmp(list.words[unique - 1], list.words[i]) != 0) {
+			list.words[unique++] = list.words[i];
+		} else {
+			free(list.words[i]);
+		}
+	}
+
+	return buildPerfectHash(ph, list.words, unique);
+}
+
+//Filters words through a stop word table before passing the rest on to another visitor.
+typedef struct StopwordFilter {
+	const perfectHash *stopwords;
+	void (*visit)(char *word, int wordLength, void *context);
+	void *context;
+} stopwordFilter;
+
+//Returns 1 if the "wordLength" bytes at "word" are in "stopwords", ignoring case, or 0 otherwise.
+int isStopword(const perfectHash *stopwords, char *word, int wordLength) {
+	char lower[STOPWORD_MAX_LENGTH];
+	int i = 0;
+
+	if (wordLength >= STOPWORD_MAX_LENGTH) {
+		return 0;
+	}
+
+	for (i = 0; i < wordLength; i++) {
+		lower[i] = tolower((unsigned char) word[i]);
+	}
+
+	return perfectContains(stopwords, lower, wordLength);
+}
+
+//Word visitor which passes the word on unless it is a stop word, ignoring case, using the stopwordFilter pointed to by "context".
+void stopwordVisitor(char *word, int wordLength, void *context) {
+	stopwordFilter *filter = context;
+
+	if (!isStopword(filter->stopwords, word, wordLength)) {
+		filter->visit(word, wordLength, filter->context);
+	}
+}
+
+//Like forEachWord, but words in "stopwords" are skipped. With NULL stop words, every word is visited.
+void forEachWordExcept(char *text, size_t length, const perfectHash *stopwords, void (*visit)(char *word, int wordLength, void *context), void *context) {
+	stopwordFilter filter;
+
+	filter.stopwords = stopwords;
+	filter.visit = visit;
+	filter.context = context;
+	forEachWord(text, length, stopwords == NULL ? visit : stopwordVisitor, stopwords == NULL ? context : &filter);
+}
+
+/*
+ * Natural runs. Before anything is sorted, the tokens are scanned in input order for runs that are already ascending or strictly descending. Runs
+ * of at least MIN_RUN words are kept as they are (descending ones reversed in place), and only the words between them go into the tree. The runs
+ * and the flattened tree are then merged through a heap into one sorted array without duplicates, so input appended to a sorted dump costs
+ * little more than reading it.
+ */
+
+#define MIN_RUN 32
+
+//The part of one sorted run not yet merged.
+typedef struct Run {
+	char **next;
+	char **end;
+} run;
+
+//Reverses "count" words in place.
+void reverseWords(char **words, int count) {
+	char *swap = NULL;
+	int i = 0;
+
+	for (i = 0; i < count / 2; i++) {
+		swap = words[i];
+		words[i] = words[count - 1 - i];
+		words[count - 1 - i] = swap;
+	}
+}
+
+//Restores the heap order of "heap" below position "i", where the heap holds "count" runs ordered by their next words.
+void runSiftDown(run *heap, int count, int i) {
+	run swap;
+	int smallest = i;
+
+	while (1) {
+		if (2 * i + 1 < count && strcmp(*heap[2 * i + 1].next, *heap[smallest].next) < 0) {
+			smallest = 2 * i + 1;
+		}
+
+		if (2 * i + 2 < count && strcmp(*heap[2 * i + 2].next, *heap[smallest].next) < 0) {
+			smallest = 2 * i + 2;
+		}
+
+		if (smallest == i) {
+			return;
+		}
+
+		swap = heap[i];
+		heap[i] = heap[smallest];
+		heap[smallest] = swap;
+		i = smallest;
+	}
+}
+
+/*
+ * Sorts the words of "list" using its natural runs, inserting the words outside long runs into the tree pointed to by "root". Returns a malloc'd
+ * array of the distinct words in sorted order and stores their number in "count". The words still belong to "list".
+ */
+char** sortRuns(wordList *list, node **root, int *count) {
+	run *runs = malloc((list->count / MIN_RUN + 2) * sizeof(run));
+	char **words = list->words
+            ,**treeWords = NULL
+            ,**sorted = malloc((list->count + 1) * sizeof(char *));
+	int runCount = 0
+           ,descending = 0
+           ,i = 0
+           ,j = 0;
+
+	while (i < list->count) {
+		j = i + 1;
+		descending = j < list->count && strcmp(words[i], words[j]) > 0;
+
+		//Descending runs are strict, as in TimSort, so reversing one never reorders equal words.
+		while (j < list->count && (descending ? strcmp(words[j - 1], words[j]) > 0 : strcmp(words[j - 1], words[j]) <= 0)) {
+			j++;
+		}
+
+		if (j - i >= MIN_RUN) {
+			if (descending) {
+				reverseWords(words + i, j - i);
+			}
+
+			runs[runCount].next = words + i;
+			runs[runCount].end = words + j;
+			runCount++;
+		} else {
+			for (; i < j; i++) {
+				*root = insert(*root, words[i]);
+			}
+		}
+
+		i = j;
+	}
+
+	//Whatever went into the tree is one more sorted run.
+	if (*root != NULL) {
+		treeWords = malloc((countNodes(*root) + 1) * sizeof(char *));
+		runs[runCount].next = treeWords;
+		runs[runCount].end = treeWords + countNodes(*root);
+		flattenTree(*root, treeWords, 0);
+		runCount++;
+	}
+
+	for (i = runCount / 2 - 1; i >= 0; i--) {
+		runSiftDown(runs, runCount, i);
+	}
+
+	*count = 0;
+
+	while (runCount > 0) {
+		if (*count == 0 || strcmp(sorted[*count - 1], *runs[0].next) != 0) {
+			sorted[(*count)++] = *runs[0].next;
+		}
+
+		if (++runs[0].next == runs[0].end) {
+			runs[0] = runs[--runCount];
+		}
+
+		runSiftDown(runs, runCount, 0);
+	}
+
+	free(treeWords);
+	free(runs);
+
+	return sorted;
+}
+
+/*
+ * Tumbling-window word counts for timestamped lines read from standard input. Each line starts with a whole, non-negative timestamp in seconds, and the rest of it is
+ * tokenized into the current window's tree. When a line belongs to a later window, the current window's sorted counts are printed and its tree is
+ * thrown away by resetting the arena that holds all its nodes and words, so memory stays bounded however long the stream runs.
+ */
+
+typedef struct TumblingWindow {
+	node *root;
+	bumpArena arena;
+} tumblingWindow;
+
+//Word visitor which counts the word in the tumblingWindow pointed to by "context". Words are only copied into the arena the first time they're seen.
+void tumblingVisitor(char *word, int wordLength, void *context) {
+	tumblingWindow *window = context;
+	node *n = NULL;
+	char saved = word[wordLength];
+
+	word[wordLength] = '\0';
+	window->root = insertNodeIn(window->root, word, &n, &window->arena);
+	word[wordLength] = saved;
+
+	if (getWord(n) == word) {
+		setWord(n, bumpCopy(&window->arena, word, wordLength));
+	}
+}
+
+//Prints each word in the tree with root node "root" and its count, in sorted order.
+void printCounts(node *root) {
+	if (root == NULL) {
+		return;
+	}
+
+	printCounts(getLeftChild(root));
+	printf("%s %d\n", getWord(root), root->count);
+	printCounts(getRightChild(root));
+}
+
+//Prints the counts of window "window" starting at "start" seconds, then empties it.
+void flushWindow(tumblingWindow *window, long long start) {
+	printf("# window %lld\n", start);
+	printCounts(window->root);
+	fflush(stdout);
+	window->root = NULL;
+	bumpReset(&window->arena);
+}
+
+//Counts words from standard input in tumbling windows of "seconds" seconds. Returns 0 on success.
+int countTumbling(long long seconds) {
+	tumblingWindow window;
+	char *line = NULL
+            ,*message = NULL;
+	size_t capacity = 0;
+	ssize_t length = 0;
+	long long start = 0
+                 ,lineStart = 0;
+	int started = 0;
+
+	window.root = NULL;
+	bumpInit(&window.arena);
+
+	while ((length = getline(&line, &capacity, stdin)) >= 0) {
+		errno = 0;
+		lineStart = strtoll(line, &message, 10);
+
+		//Lines without a timestamp, or with one that is negative or out of range, are skipped.
+		if (message == line || errno != 0 || lineStart < 0 || (*message != '\0' && !isspace((unsigned char) *message))) {
+			continue;
+		}
+
+		lineStart -= lineStart % seconds;
+
+		//Late lines are counted in the current window rather than reopening one that has already been printed.
+		if (!started) {
+			start = lineStart;
+			started = 1;
+		} else if (lineStart > start) {
+			flushWindow(&window, start);
+			start = lineStart;
+		}
+
+		forEachWord(message, length - (message - line), tumblingVisitor, &window);
+	}
+
+	if (started) {
+		flushWindow(&window, start);
+	}
+
+	free(line);
+	recycleBump(&window.arena);
+
+	return 0;
+}
+
+/*
+ * Word n-gram counts. Every token is interned to a word ID, and the IDs are then renumbered so that ID order is the words' sorted order. An n-gram
+ * is just a position in the resulting ID stream, and two n-grams compare as "n"-wide tuples of integers, so counting them in an ordered set never
+ * copies or compares strings. A dropped stop word leaves a break in the stream, so no n-gram spans words that weren't next to each other.
+ */
+
+#define NGRAM_BREAK UINT32_MAX
+
+typedef struct NgramCounter {
+	char **words; //words[id] is the word with that ID.
+	uint32_t *slots; //Open-addressing table of word IDs plus one; 0 marks an empty slot.
+	uint64_t mask;
+	uint32_t wordCount;
+	uint32_t *tokens; //The ID of every token in the input, in order.
+	uint32_t tokenCount;
+	uint32_t tokenCapacity;
+	const perfectHash *stopwords; //Words to replace with NGRAM_BREAK, or NULL.
+	bumpArena arena;
+} ngramCounter;
+
+//Returns the ID of the "length" bytes at "word" in "c", giving them a new ID if they haven't been seen before.
+uint32_t internWord(ngramCounter *c, char *word, int length) {
+	uint64_t index = hashBytes(word, length) & c->mask
+                ,i = 0;
+	uint32_t *slots = NULL;
+	char *known = NULL;
+
+	while (c->slots[index] != 0) {
+		known = c->words[c->slots[index] - 1];
+
+		if (strncmp(known, word, length) == 0 && known[length] == '\0') {
+			return c->slots[index] - 1;
+		}
+
+		index = (index + 1) & c->mask;
+	}
+
+	c->words[c->wordCount] = bumpCopy(&c->arena, word, length);
+	c->slots[index] = ++c->wordCount;
+
+	//Keep the table at most half full; the word array grows along with it.
+	if ((uint64_t) c->wordCount * 2 > c->mask + 1) {
+		slots = calloc((c->mask + 1) * 2, sizeof(uint32_t));
+		c->mask = c->mask * 2 + 1;
+		c->words = realloc(c->words, ((c->mask + 1) / 2 + 1) * sizeof(char *));
+
+		for (i = 0; i < c->wordCount; i++) {
+			index = hashBytes(c->words[i], strlen(c->words[i])) & c->mask;
+
+			while (slots[index] != 0) {
+				index = (index + 1) & c->mask;
+			}
+
+			slots[index] = i + 1;
+		}
+
+		free(c->slots);
+		c->slots = slots;
+	}
+
+	return c->wordCount - 1;
+}
+
+//Word visitor which appends the word's ID, or a break for a stop word, to the token stream of the ngramCounter pointed to by "context".
+void ngramVisitor(char *word, int wordLength, void *context) {
+	ngramCounter *c = context;
+
+	if (c->tokenCount == c->tokenCapacity) {
+		c->tokenCapacity *= 2;
+		c->tokens = realloc(c->tokens, c->tokenCapacity * sizeof(uint32_t));
+	}
+
+	if (c->stopwords != NULL && isStopword(c->stopwords, word, wordLength)) {
+		c->tokens[c->tokenCount++] = NGRAM_BREAK;
+	} else {
+		c->tokens[c->tokenCount++] = internWord(c, word, wordLength);
+	}
+}
+
+//qsort_r comparator for word IDs, ordering them by their words in the ngramCounter "context".
+int compareWordIds(const void *a, const void *b, void *context) {
+	ngramCounter *c = context;
+
+	return strcmp(c->words[*(const uint32_t *) a], c->words[*(const uint32_t *) b]);
+}
+
+//An n-gram: the IDs of its "n" words, pointing into the token stream.
+typedef struct NgramKey {
+	uint32_t *ids;
+	int n;
+} ngramKey;
+
+//Compares two n-grams as tuples of sorted-order word IDs.
+static inline int compareNgramKeys(ngramKey a, ngramKey b) {
+	int i = 0;
+
+	for (i = 0; i < a.n; i++) {
+		if (a.ids[i] != b.ids[i]) {
+			return a.ids[i] < b.ids[i] ? -1 : 1;
+		}
+	}
+
+	return 0;
+}
+
+DEFINE_RBSET(ngramSet, ngramKey, uint32_t, compareNgramKeys)
+
+//Prints every distinct "n"-word n-gram in the first "length" characters of "text" with its count, in sorted order. If "stopwords" isn't NULL, no
+//n-gram includes one of them or spans one. Returns 0 on success.
+int countNgrams(char *text, size_t length, int n, const perfectHash *stopwords) {
+	ngramCounter c;
+	ngramKey key;
+	ngramSetNode *grams = NULL
+                     ,*gram = NULL;
+	uint32_t *order = NULL
+                ,*ranks = NULL
+                ,i = 0
+                ,run = 0;
+	int k = 0;
+
+	c.mask = 1023;
+	c.slots = calloc(c.mask + 1, sizeof(uint32_t));
+	c.words = malloc(((c.mask + 1) / 2 + 1) * sizeof(char *));
+	c.wordCount = 0;
+	c.tokenCapacity = 1024;
+	c.tokenCount = 0;
+	c.tokens = malloc(c.tokenCapacity * sizeof(uint32_t));
+	c.stopwords = stopwords;
+	bumpInit(&c.arena);
+
+	forEachWord(text, length, ngramVisitor, &c);
+
+	//Renumber the IDs by sorted order of their words, so comparing IDs compares words.
+	order = malloc((c.wordCount + 1) * sizeof(uint32_t));
+	ranks = malloc((c.wordCount + 1) * sizeof(uint32_t));
+
+	for (i = 0; i < c.wordCount; i++) {
+		order[i] = i;
+	}
+
+	qsort_r(order, c.wordCount, sizeof(uint32_t), compareWordIds, &c);
+
+	for (i = 0; i < c.wordCount; i++) {
+		ranks[order[i]] = i;
+	}
+
+	for (i = 0; i < c.tokenCount; i++) {
+		if (c.tokens[i] != NGRAM_BREAK) {
+			c.tokens[i] = ranks[c.tokens[i]];
+		}
+	}
+
+	//Each n-gram is counted in the set's value for it, and the nodes come from the same arena as the words. "run" counts the tokens since the
+	//last break, so an n-gram ends at every token with at least "n" of them.
+	key.n = n;
+
+	for (i = 0; i < c.tokenCount; i++) {
+		run = c.tokens[i] == NGRAM_BREAK ? 0 : run + 1;
+
+		if (run >= (uint32_t) n) {
+			key.ids = c.tokens + i + 1 - n;
+			grams = ngramSetInsert(grams, key, &gram, &c.arena);
+			gram->value++;
+		}
+	}
+
+	for (gram = ngramSetMinimum(grams); gram != NULL; gram = ngramSetSuccessor(gram)) {
+		for (k = 0; k < n; k++) {
+			printf("%s ", c.words[order[gram->key.ids[k]]]);
+		}
+
+		printf("%u\n", gram->value);
+	}
+
+	free(order);
+	free(ranks);
+	free(c.slots);
+	free(c.words);
+	free(c.tokens);
+	recycleBump(&c.arena);
+
+	return 0;
+}
+
+/*
+ * Prefix-sharded trees for concurrent insertion. Words are split into one tree per possible first letter, each with its own lock, so tokenizer threads
+ * inserting different words rarely wait on each other. Every uppercase letter sorts before every lowercase letter, so the shards' in-order traversals
+ * concatenated in shard order are the sorted order of all the words.
+ */
+
+#define PREFIX_SHARDS 52
+
+typedef struct ShardedTree {
+	node *roots[PREFIX_SHARDS];
+	pthread_mutex_t locks[PREFIX_SHARDS];
+} shardedTree;
+
+//Returns the shard for words starting with the letter "first": A-Z are shards 0-25 and a-z are shards 26-51.
+int prefixShard(char first) {
+	if (first >= 'a') {
+		return 26 + (first - 'a');
+	}
+
+	return first - 'A';
+}
+
+//Sets up an empty sharded tree.
+void shardedInit(shardedTree *t) {
+	int i = 0;
+
+	for (i = 0; i < PREFIX_SHARDS; i++) {
+		t->roots[i] = NULL;
+		pthread_mutex_init(&t->locks[i], NULL);
+	}
+}
+
+//Frees all the shards of a sharded tree.
+void recycleSharded(shardedTree *t) {
+	int i = 0;
+
+	for (i = 0; i < PREFIX_SHARDS; i++) {
+		recycleTree(t->roots[i]);
+		pthread_mutex_destroy(&t->locks[i]);
+	}
+}
+
+//Inserts "word" into its shard of the sharded tree "t". Safe to call from several threads at once. Frees "word" if it was already there.
+void shardedInsert(shardedTree *t, char *word) {
+	int shard = prefixShard(word[0]);
+	node *inserted = NULL;
+
+	pthread_mutex_lock(&t->locks[shard]);
+	t->roots[shard] = insertNode(t->roots[shard], word, &inserted);
+	pthread_mutex_unlock(&t->locks[shard]);
+
+	if (getWord(inserted) != word) {
+		free(word);
+	}
+}
+
+//Word visitor which copies the word and inserts it into the shardedTree pointed to by "context". The copy is made before taking any lock.
+void shardedVisitor(char *word, int wordLength, void *context) {
+	shardedInsert(context, strndup(word, wordLength));
+}
+
+//Returns the number of words in all the shards of "t".
+int shardedCount(shardedTree *t) {
+	int count = 0
+           ,i = 0;
+
+	for (i = 0; i < PREFIX_SHARDS; i++) {
+		count += countNodes(t->roots[i]);
+	}
+
+	return count;
+}
+
+//Copies the words of all the shards of "t" into "words" in sorted order. Returns the number of words copied.
+int flattenSharded(shardedTree *t, char **words) {
+	int count = 0
+           ,i = 0;
+
+	for (i = 0; i < PREFIX_SHARDS; i++) {
+		count = flattenTree(t->roots[i], words, count);
+	}
+
+	return count;
+}
+
+//Describes the slice of the input one tokenizer thread visits.
+typedef struct TokenizeJob {
+	char *text;
+	size_t length;
+	void (*visit)(char *word, int wordLength, void *context);
+	void *context;
+} tokenizeJob;
+
+//Thread body which tokenizes one slice of the input.
+void* tokenizeRange(void *arg) {
+	tokenizeJob *job = arg;
+
+	forEachWord(job->text, job->length, job->visit, job->context);
+
+	return NULL;
+}
+
+//Like forEachWord, but splits the text into "threads" equal slices which are tokenized at the same time. "visit" must be safe to call concurrently.
+void forEachWordParallel(char *text, size_t length, int threads, void (*visit)(char *word, int wordLength, void *context), void *context) {
+	tokenizeJob *jobs = malloc(threads * sizeof(tokenizeJob));
+	pthread_t *workers = malloc(threads * sizeof(pthread_t));
+	size_t start = 0
+              ,end = 0;
+	int i = 0;
+
+	for (i = 0; i < threads; i++) {
+		//Slices end just after a non-letter, so no word is split between two threads.
+		end = i == threads - 1 ? length : length / threads * (i + 1) + length % threads * (i + 1) / threads;
+
+		while (end < length && end > start && isalpha(text[end - 1])) {
+			end++;
+		}
+
+		if (end < start) {
+			end = start;
+		}
+
+		jobs[i].text = text + start;
+		jobs[i].length = end - start;
+		jobs[i].visit = visit;
+		jobs[i].context = context;
+		startOrRun(&workers[i], tokenizeRange, &jobs[i]);
+		start = end;
+	}
+
+	for (i = 0; i < threads; i++) {
+		joinStarted(workers[i]);
+	}
+
+	free(jobs);
+	free(workers);
+}
+
+/*
+ * Concurrent string arena. Strings are bump-allocated out of large chunks with an atomic add, so threads only take the lock when a chunk runs out.
+ * Strings are never freed one at a time; the whole arena is freed at once.
+ */
+
+typedef struct StringArena {
+	arenaChunk *current;
+	pthread_mutex_t lock;
+} stringArena;
+
+//Sets up an empty string arena.
+void arenaInit(stringArena *a) {
+	a->current = NULL;
+	pthread_mutex_init(&a->lock, NULL);
+}
+
+//Frees every string ever allocated from arena "a".
+void recycleArena(stringArena *a) {
+	arenaChunk *chunk = a->current
+                  ,*next = NULL;
+
+	while (chunk != NULL) {
+		next = chunk->next;
+		free(chunk);
+		chunk = next;
+	}
+
+	a->current = NULL;
+	pthread_mutex_destroy(&a->lock);
+}
+
+//Copies "length" bytes at "word" into arena "a" as a NUL-terminated string and returns the copy. Safe to call from several threads at once.
+char* arenaCopy(stringArena *a, char *word, int length) {
+	arenaChunk *chunk = NULL;
+	size_t offset = 0
+              ,size = 0;
+	char *copy = NULL;
+
+	for (;;) {
+		chunk = __atomic_load_n(&a->current, __ATOMIC_ACQUIRE);
+
+		if (chunk != NULL) {
+			offset = __atomic_fetch_add(&chunk->used, length + 1, __ATOMIC_RELAXED);
+
+			if (offset + length + 1 <= chunk->size) {
+				copy = chunk->bytes + offset;
+				break;
+			}
+		}
+
+		//The chunk is full. Only the first thread to notice replaces it; the others retry with the new one.
+		pthread_mutex_lock(&a->lock);
+
+		if (__atomic_load_n(&a->current, __ATOMIC_ACQUIRE) == chunk) {
+			size = length + 1 > ARENA_CHUNK_SIZE ? length + 1 : ARENA_CHUNK_SIZE;
+			chunk = malloc(sizeof(arenaChunk) + size);
+			chunk->next = a->current;
+			chunk->size = size;
+			chunk->used = 0;
+			__atomic_store_n(&a->current, chunk, __ATOMIC_RELEASE);
+		}
+
+		pthread_mutex_unlock(&a->lock);
+	}
+
+	memcpy(copy, word, length);
+	copy[length] = '\0';
+
+	return copy;
+}
+
+/*
+ * Concurrent open-addressing hash set of words, used to deduplicate the input on all tokenizer threads before anything is sorted. Slots are probed
+ * linearly and claimed with a compare-and-swap, and a claimed slot never changes again, so a word that is already there is found without writing
+ * anything shared at all. A word is only copied into the arena once it reaches an empty slot. When the table gets half full, one thread grows it
+ * under the grow lock: it freezes every empty slot of the old table with a marker so nothing more can land there, copies the words into a table
+ * twice the size and publishes that. Inserters that run into a frozen slot wait on the grow lock and retry in the new table. Old tables are kept
+ * until the set is freed, because slower threads may still be reading them.
+ */
+
+typedef struct DedupeTable {
+	char **slots; //NULL marks an empty slot, and dedupeMoved one frozen while the table is copied into a bigger one.
+	uint64_t mask; //The number of slots minus one. The number of slots is always a power of two.
+	uint64_t count;
+	struct DedupeTable *previous; //The smaller table this one replaced.
+} dedupeTable;
+
+typedef struct DedupeSet {
+	dedupeTable *table;
+	pthread_mutex_t growLock; //Only taken to grow the table, or to wait for another thread to finish growing it.
+	stringArena arena;
+} dedupeSet;
+
+//Marks the frozen slots of a table being grown. Only its address is used.
+char dedupeMoved[1];
+
+//Returns a new empty table with "slots" slots, which must be a power of two.
+dedupeTable* dedupeTableNew(uint64_t slots) {
+	dedupeTable *table = malloc(sizeof(dedupeTable));
+
+	table->slots = calloc(slots, sizeof(char *));
+	table->mask = slots - 1;
+	table->count = 0;
+	table->previous = NULL;
+
+	return table;
+}
+
+//Sets up an empty set with "slots" slots, which must be a power of two.
+void dedupeInit(dedupeSet *set, uint64_t slots) {
+	set->table = dedupeTableNew(slots);
+	pthread_mutex_init(&set->growLock, NULL);
+	arenaInit(&set->arena);
+}
+
+//Frees the set, every table it has had and every word in it.
+void recycleDedupe(dedupeSet *set) {
+	dedupeTable *table = set->table
+                   ,*previous = NULL;
+
+	while (table != NULL) {
+		previous = table->previous;
+		free(table->slots);
+		free(table);
+		table = previous;
+	}
+
+	pthread_mutex_destroy(&set->growLock);
+	recycleArena(&set->arena);
+}
+
+//Replaces the table of "set" with one twice the size holding the same words. The caller must hold the grow lock.
+void dedupeGrow(dedupeSet *set) {
+	dedupeTable *old = set->table
+                   ,*table = dedupeTableNew((old->mask + 1) * 2);
+	uint64_t index = 0
+                ,i = 0;
+	char *slot = NULL;
+
+	for (i = 0; i <= old->mask; i++) {
+		//Freeze the slot if it is still empty. If an inserter claims it first, its word is copied like any other.
+		slot = NULL;
+
+		if (__atomic_compare_exchange_n(&old->slots[i], &slot, dedupeMoved, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+			continue;
+		}
+
+		index = hashBytes(slot, strlen(slot)) & table->mask;
+
+		while (table->slots[index] != NULL) {
+			index = (index + 1) & table->mask;
+		}
+
+		table->slots[index] = slot;
+		table->count++;
+	}
+
+	table->previous = old;
+	__atomic_store_n(&set->table, table, __ATOMIC_RELEASE);
+}
+
+//Grows "set" unless another thread already has since its caller saw "table". Either way, the new table is published when this returns.
+void dedupeMakeRoom(dedupeSet *set, dedupeTable *table) {
+	pthread_mutex_lock(&set->growLock);
+
+	if (set->table == table) {
+		dedupeGrow(set);
+	}
+
+	pthread_mutex_unlock(&set->growLock);
+}
+
+/*
+ * Adds the "length" bytes at "word" to "set" if they aren't there already. Safe to call from several threads at once, and takes no lock unless the
+ * table needs growing: past half full, on a frozen slot, or after probing every slot without finding room.
+ */
+void dedupeAdd(dedupeSet *set, char *word, int length) {
+	dedupeTable *table = NULL;
+	uint64_t h = hashBytes(word, length)
+                ,index = 0
+                ,probes = 0;
+	char *slot = NULL
+            ,*copy = NULL;
+
+	for (;;) {
+		table = __atomic_load_n(&set->table, __ATOMIC_ACQUIRE);
+
+		//Grow once the table is half full, so probe sequences stay short.
+		if (__atomic_load_n(&table->count, __ATOMIC_RELAXED) * 2 > table->mask + 1) {
+			dedupeMakeRoom(set, table);
+			continue;
+		}
+
+		index = h & table->mask;
+
+		for (probes = 0; probes <= table->mask; probes++) {
+			slot = __atomic_load_n(&table->slots[index], __ATOMIC_ACQUIRE);
+
+			if (slot == NULL) {
+				if (copy == NULL) {
+					copy = arenaCopy(&set->arena, word, length);
+				}
+
+				if (__atomic_compare_exchange_n(&table->slots[index], &slot, copy, 0, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE)) {
+					__atomic_add_fetch(&table->count, 1, __ATOMIC_RELAXED);
+					return;
+				}
+
+				//Another thread claimed or froze the slot first; "slot" now holds what it put there.
+			}
+
+			if (slot == dedupeMoved) {
+				break;
+			}
+
+			if (strncmp(slot, word, length) == 0 && slot[length] == '\0') {
+				//Already there. A copy made for a lost race is left in the arena.
+				return;
+			}
+
+			index = (index + 1) & table->mask;
+		}
+
+		//The table is being grown, or every slot is taken by other words. Either way, retry in the grown table.
+		dedupeMakeRoom(set, table);
+	}
+}
+
+//Word visitor which adds the word to the dedupeSet pointed to by "context".
+void dedupeVisitor(char *word, int wordLength, void *context) {
+	dedupeAdd(context, word, wordLength);
+}
+
+//Inserts every word in "set" into the tree with root node "root" and returns the root afterwards. The tree shares the set's copies of the words.
+node* insertDeduped(node *root, dedupeSet *set) {
+	uint64_t i = 0;
+
+	for (i = 0; i <= set->table->mask; i++) {
+		if (set->table->slots[i] != NULL) {
+			root = insert(root, set->table->slots[i]);
+		}
+	}
+
+	return root;
+}
+
+/*
+ * Frozen vocabulary layout: a header, then "count" offsets into the string pool, then the pool itself holding each word NUL-terminated in sorted order.
+ * It has no pointers in it, so it can be mapped read-only at any address by any process and searched in place.
+ */
+
+#define FROZEN_MAGIC 0x70736f72 //Stored as the bytes "rosp" on little-endian machines, so text can start with it too.
+#define FROZEN_VERSION 1
+
+typedef struct FrozenHeader {
+	uint32_t magic; //Written last, so a reader that sees it knows the rest of the segment is complete.
+	uint32_t version; //Layout version. Readers reject layouts they don't know.
+	uint64_t generation; //Incremented on every publish, so readers that open the name again can tell whether they got a newer vocabulary.
+	uint64_t count;
+	uint64_t poolSize;
+} frozenHeader;
+
+//Returns the offsets array which follows the header "h".
+uint64_t* frozenOffsets(frozenHeader *h) {
+	return (uint64_t *) (h + 1);
+}
+
+//Returns the word with rank "i" in the frozen vocabulary "h".
+char* frozenWord(frozenHeader *h, uint64_t i) {
+	return (char *) (frozenOffsets(h) + h->count) + frozenOffsets(h)[i];
+}
+
+//Returns the number of bytes needed to freeze "count" sorted words.
+size_t frozenSize(char **words, int count) {
+	size_t size = sizeof(frozenHeader) + count * sizeof(uint64_t);
+	int i = 0;
+
+	for (i = 0; i < count; i++) {
+		size += strlen(words[i]) + 1;
+	}
+
+	return size;
+}
+
+//Writes "count" sorted words into "h" in the frozen layout. "h" must have room for frozenSize bytes.
+void freezeWords(char **words, int count, uint64_t generation, frozenHeader *h) {
+	uint64_t *offsets = NULL;
+	char *pool = NULL;
+	size_t used = 0
+              ,wordLength = 0;
+	int i = 0;
+
+	h->version = FROZEN_VERSION;
+	h->generation = generation;
+	h->count = count;
+	offsets = frozenOffsets(h);
+	pool = (char *) (offsets + count);
+
+	for (i = 0; i < count; i++) {
+		wordLength = strlen(words[i]) + 1;
+		offsets[i] = used;
+		memcpy(pool + used, words[i], wordLength);
+		used += wordLength;
+	}
+
+	h->poolSize = used;
+	__atomic_store_n(&h->magic, FROZEN_MAGIC, __ATOMIC_RELEASE);
+}
+
+//Checks that "size" bytes at "h" hold a complete frozen vocabulary this program understands. Returns 1 if so, 0 otherwise.
+int frozenValid(frozenHeader *h, size_t size) {
+	if (size < sizeof(frozenHeader) || __atomic_load_n(&h->magic, __ATOMIC_ACQUIRE) != FROZEN_MAGIC || h->version != FROZEN_VERSION) {
+		return 0;
+	}
+
+	return h->count <= (size - sizeof(frozenHeader)) / sizeof(uint64_t)
+	    && h->poolSize == size - sizeof(frozenHeader) - h->count * sizeof(uint64_t);
+}
+
+//Binary searches the frozen vocabulary "h" for "word". Returns its rank, or -1 if it is not there.
+long frozenFind(frozenHeader *h, char *word) {
+	uint64_t low = 0
+                ,high = h->count
+                ,middle = 0;
+	int cmp = 0;
+
+	while (low < high) {
+		middle = low + (high - low) / 2;
+		cmp = strcmp(word, frozenWord(h, middle));
+
+		if (cmp == 0) {
+			return middle;
+		} else if (cmp < 0) {
+			high = middle;
+		} else {
+			low = middle + 1;
+		}
+	}
+
+	return -1;
+}
+
+/*
+ * Publishes "count" sorted words in the POSIX shared memory segment "name". The new segment is filled under a temporary name and then renamed over
+ * the old one in /dev/shm, so opening "name" always finds a complete vocabulary. Readers that still have the old segment mapped keep that copy
+ * unchanged; to pick up a newer one they map "name" again and compare generations.
+ * Returns 0 on success or -1 on error.
+ */
+int publishShared(char *name, char **words, int count) {
+	frozenHeader *h = NULL;
+	struct stat info;
+	uint64_t generation = 1;
+	size_t size = frozenSize(words, count);
+	char temporary[256]
+            ,from[300]
+            ,to[300];
+	int fd = shm_open(name, O_RDONLY, 0);
+
+	if (fd >= 0) {
+		if (fstat(fd, &info) == 0 && (size_t) info.st_size >= sizeof(frozenHeader)) {
+			h = mmap(NULL, sizeof(frozenHeader), PROT_READ, MAP_SHARED, fd, 0);
+
+			if (h != MAP_FAILED) {
+				generation = h->generation + 1;
+				munmap(h, sizeof(frozenHeader));
+			}
+		}
+
+		close(fd);
+	}
+
+	snprintf(temporary, sizeof(temporary), "%s.%d", name, (int) getpid());
+	shm_unlink(temporary);
+	fd = shm_open(temporary, O_RDWR | O_CREAT | O_EXCL, 0644);
+
+	if (fd < 0) {
+		return -1;
+	}
+
+	if (ftruncate(fd, size) != 0) {
+		close(fd);
+		shm_unlink(temporary);
+		return -1;
+	}
+
+	h = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (h == MAP_FAILED) {
+		shm_unlink(temporary);
+		return -1;
+	}
+
+	freezeWords(words, count, generation, h);
+	munmap(h, size);
+
+	//shm_open has no rename of its own, but on Linux the segments are files in /dev/shm.
+	snprintf(from, sizeof(from), "/dev/shm/%s", temporary + (temporary[0] == '/'));
+	snprintf(to, sizeof(to), "/dev/shm/%s", name + (name[0] == '/'));
+
+	if (rename(from, to) != 0) {
+		shm_unlink(temporary);
+		return -1;
+	}
+
+	return 0;
+}
+
+//Maps the shared memory segment "name" read-only and stores its size in "size". Returns the mapping, or NULL if it is missing or invalid.
+frozenHeader* mapShared(char *name, size_t *size) {
+	frozenHeader *h = NULL;
+	struct stat info;
+	int fd = shm_open(name, O_RDONLY, 0);
+
+	if (fd < 0) {
+		return NULL;
+	}
+
+	if (fstat(fd, &info) != 0 || info.st_size == 0) {
+		close(fd);
+		return NULL;
+	}
+
+	*size = info.st_size;
+	h = mmap(NULL, *size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (h == MAP_FAILED) {
+		return NULL;
+	}
+
+	if (!frozenValid(h, *size)) {
+		munmap(h, *size);
+		return NULL;
+	}
+
+	return h;
+}
+
+//Writes "count" sorted words to the file "path" in the frozen layout, for use as a base dictionary. Returns 0 on success or -1 on error.
+int writeFrozen(char *path, char **words, int count) {
+	size_t size = frozenSize(words, count);
+	frozenHeader *h = malloc(size);
+	int result = 0;
+
+	freezeWords(words, count, 1, h);
+	result = writeFile(path, h, size);
+	free(h);
+
+	return result;
+}
+
+/*
+ * Two-tier vocabulary. A frozen base dictionary is mapped straight from a file and searched in place, and only words missing from it are inserted
+ * into the tree, so the tree stays small. The two are disjoint and both sorted, so output is a single merge.
+ */
+
+typedef struct TwoTier {
+	frozenHeader *base;
+	node *delta;
+} twoTier;
+
+//Word visitor which inserts the word into the delta tree of the twoTier pointed to by "context" unless the base dictionary already has it.
+void twoTierVisitor(char *word, int wordLength, void *context) {
+	twoTier *tiers = context;
+	char saved = word[wordLength];
+	long rank = 0;
+
+	word[wordLength] = '\0';
+	rank = frozenFind(tiers->base, word);
+	word[wordLength] = saved;
+
+	if (rank < 0) {
+		insertVisitor(word, wordLength, &tiers->delta);
+	}
+}
+
+//Prints the union of the frozen base dictionary "base" and "count" sorted words, which must not be in the base, in sorted order.
+void printMerged(frozenHeader *base, char **words, int count) {
+	uint64_t i = 0;
+	int j = 0;
+
+	while (i < base->count || j < count) {
+		if (j == count || (i < base->count && strcmp(frozenWord(base, i), words[j]) < 0)) {
+			fputs(frozenWord(base, i++), stdout);
+		} else {
+			fputs(words[j++], stdout);
+		}
+
+		putchar('\n');
+	}
+}
+
+//Word visitor which prints the word if it is missing from the frozen vocabulary pointed to by "context".
+void frozenCheckVisitor(char *word, int wordLength, void *context) {
+	char saved = word[wordLength];
+
+	word[wordLength] = '\0';
+
+	if (frozenFind(context, word) < 0) {
+		printf("%s\n", word);
+	}
+
+	word[wordLength] = saved;
+}
+
+/*
+ * Anagram classes. Each word's signature is its letters in sorted order, found with a counting sort since words are letters only. Keys made of the
+ * signature, a space and the word go into a second tree, so an in-order walk visits each anagram class together, with its words in sorted order.
+ * The space sorts before every letter, so a signature that is a prefix of another still sorts first.
+ */
+
+//Returns a malloc'd anagram key for "word": its letters sorted, a space, then the word itself.
+char* anagramKey(char *word) {
+	int counts[256] = {0}
+           ,length = strlen(word)
+           ,letter = 0
+           ,i = 0;
+	char *key = malloc(length * 2 + 2);
+
+	for (i = 0; i < length; i++) {
+		counts[(unsigned char) word[i]]++;
+	}
+
+	for (letter = 0, i = 0; letter < 256; letter++) {
+		while (counts[letter]-- > 0) {
+			key[i++] = letter;
+		}
+	}
+
+	key[i++] = ' ';
+	memcpy(key + i, word, length + 1);
+
+	return key;
+}
+
+//Returns the tree of anagram keys for every word in the tree with root node "root".
+node* buildAnagrams(node *root) {
+	node *n = root == NULL ? NULL : getMinimum(root)
+            ,*anagrams = NULL;
+
+	for (; n != NULL; n = getSuccessor(n)) {
+		anagrams = insert(anagrams, anagramKey(getWord(n)));
+	}
+
+	return anagrams;
+}
+
+//Prints each anagram class in the tree of anagram keys with root node "anagrams" on its own line, words separated by spaces.
+void printAnagrams(node *anagrams) {
+	node *n = anagrams == NULL ? NULL : getMinimum(anagrams)
+            ,*previous = NULL;
+	char *key = NULL
+            ,*space = NULL;
+
+	for (; n != NULL; previous = n, n = getSuccessor(n)) {
+		key = getWord(n);
+		space = strchr(key, ' ');
+
+		if (previous == NULL) {
+			fputs(space + 1, stdout);
+		} else if (strncmp(getWord(previous), key, space - key + 1) == 0) {
+			printf(" %s", space + 1);
+		} else {
+			printf("\n%s", space + 1);
+		}
+	}
+
+	if (previous != NULL) {
+		putchar('\n');
+	}
+}
+
+//Frees a tree of anagram keys along with the keys.
+void recycleAnagrams(node *anagrams) {
+	if (anagrams == NULL) {
+		return;
+	}
+
+	recycleAnagrams(getLeftChild(anagrams));
+	recycleAnagrams(getRightChild(anagrams));
+	free(getWord(anagrams));
+	recycleNode(anagrams);
+}
+
+/*
+ * Vocabulary diff. An earlier run's output, either sorted text with one word per line or a frozen vocabulary file, is read one word at a time
+ * alongside an in-order walk of the new tree. Both are sorted, so one merge finds every added and removed word.
+ */
+
+typedef struct OldVocabulary {
+	FILE *file; //Set for text input.
+	char *line;
+	size_t lineCapacity;
+	frozenHeader *frozen; //Set for frozen input.
+	size_t frozenLength;
+	uint64_t next;
+} oldVocabulary;
+
+/*
+ * Opens the earlier output "path", detecting its format from its first bytes. A file that starts with the frozen magic but isn't a valid frozen
+ * vocabulary is read as text, since a word list can start with the same bytes. Returns 0 on success or -1 on error.
+ */
+int openOldVocabulary(oldVocabulary *old, char *path) {
+	uint32_t magic = 0;
+
+	old->file = fopen(path, "r");
+	old->line = NULL;
+	old->lineCapacity = 0;
+	old->frozen = NULL;
+	old->next = 0;
+
+	if (old->file == NULL) {
+		return -1;
+	}
+
+	if (fread(&magic, sizeof(magic), 1, old->file) == 1 && magic == FROZEN_MAGIC) {
+		old->frozen = mapFile(path, &old->frozenLength);
+
+		if (old->frozen != NULL && frozenValid(old->frozen, old->frozenLength)) {
+			fclose(old->file);
+			old->file = NULL;
+			return 0;
+		}
+
+		if (old->frozen != NULL) {
+			munmap(old->frozen, old->frozenLength);
+			old->frozen = NULL;
+		}
+	}
+
+	rewind(old->file);
+
+	return 0;
+}
+
+//Returns the next word of the earlier output, or NULL once it is exhausted. The word is only valid until the next call.
+char* nextOldWord(oldVocabulary *old) {
+	ssize_t length = 0;
+
+	if (old->frozen != NULL) {
+		return old->next < old->frozen->count ? frozenWord(old->frozen, old->next++) : NULL;
+	}
+
+	while ((length = getline(&old->line, &old->lineCapacity, old->file)) >= 0) {
+		while (length > 0 && (old->line[length - 1] == '\n' || old->line[length - 1] == '\r')) {
+			old->line[--length] = '\0';
+		}
+
+		if (length > 0) {
+			return old->line;
+		}
+	}
+
+	return NULL;
+}
+
+//Closes an earlier output opened with openOldVocabulary.
+void closeOldVocabulary(oldVocabulary *old) {
+	if (old->file != NULL) {
+		fclose(old->file);
+	}
+
+	if (old->frozen != NULL) {
+		munmap(old->frozen, old->frozenLength);
+	}
+
+	free(old->line);
+}
+
+//Prints "+word" for every word in the tree with root node "root" but not in "old", and "-word" for every word in "old" but not in the tree.
+void printDiff(node *root, oldVocabulary *old) {
+	node *n = root == NULL ? NULL : getMinimum(root);
+	char *word = nextOldWord(old);
+	int cmp = 0;
+
+	while (n != NULL || word != NULL) {
+		if (n == NULL) {
+			cmp = 1;
+		} else if (word == NULL) {
+			cmp = -1;
+		} else {
+			cmp = strcmp(getWord(n), word);
+		}
+
+		if (cmp < 0) {
+			printf("+%s\n", getWord(n));
+			n = getSuccessor(n);
+		} else if (cmp > 0) {
+			printf("-%s\n", word);
+			word = nextOldWord(old);
+		} else {
+			n = getSuccessor(n);
+			word = nextOldWord(old);
+		}
+	}
+}
+
+/*
+ * Minimal acyclic automaton (DAWG) export. Words are added in sorted order, which means that whenever a new word diverges from the previous one,
+ * the states below the divergence point can never change again. Those states are then either replaced by an equivalent state already in the
+ * register, or added to it. Shared suffixes end up stored once, so the automaton is much smaller than the word list and is still searchable.
+ */
+
+typedef struct DawgState {
+	char *labels; //Sorted, since words arrive in sorted order.
+	int *targets;
+	int count; //Number of transitions, or -1 once the state has been replaced by an equivalent one.
+	int capacity;
+	char final;
+} dawgState;
+
+typedef struct DawgBuilder {
+	dawgState *states;
+	int stateCount;
+	int stateCapacity;
+	int *registry; //Open-addressing set of state numbers; -1 marks an empty slot.
+	uint64_t registryMask;
+	int registered;
+	int *path; //path[d] is the state reached by the first d letters of the previous word.
+	int pathCapacity;
+	char *previous;
+	int previousLength;
+} dawgBuilder;
+
+//Adds a new state with no transitions to "b" and returns its number.
+int dawgNewState(dawgBuilder *b) {
+	dawgState *state = NULL;
+
+	if (b->stateCount == b->stateCapacity) {
+		b->stateCapacity *= 2;
+		b->states = realloc(b->states, b->stateCapacity * sizeof(dawgState));
+	}
+
+	state = &b->states[b->stateCount];
+	state->labels = NULL;
+	state->targets = NULL;
+	state->count = 0;
+	state->capacity = 0;
+	state->final = 0;
+
+	return b->stateCount++;
+}
+
+//Adds a transition on "label" from state "from" to state "to".
+void dawgAddTransition(dawgBuilder *b, int from, char label, int to) {
+	dawgState *state = &b->states[from];
+
+	if (state->count == state->capacity) {
+		state->capacity = state->capacity == 0 ? 2 : state->capacity * 2;
+		state->labels = realloc(state->labels, state->capacity);
+		state->targets = realloc(state->targets, state->capacity * sizeof(int));
+	}
+
+	state->labels[state->count] = label;
+	state->targets[state->count] = to;
+	state->count++;
+}
+
+//Returns a hash of everything that decides whether two states are equivalent: finality and the exact transitions.
+uint64_t dawgStateHash(dawgState *state) {
+	uint64_t h = state->final;
+	int i = 0;
+
+	for (i = 0; i < state->count; i++) {
+		h = (h * 31 + (unsigned char) state->labels[i]) * 0x9e3779b97f4a7c15ULL + state->targets[i];
+	}
+
+	return h ^ (h >> 29);
+}
+
+//Returns 1 if states "a" and "b" are equivalent, or 0 otherwise.
+int dawgStatesEqual(dawgState *a, dawgState *b) {
+	//States with no transitions may have no arrays at all, and memcmp can't be given null pointers even for zero bytes.
+	return a->final == b->final && a->count == b->count
+	    && (a->count == 0 || (memcmp(a->labels, b->labels, a->count) == 0 && memcmp(a->targets, b->targets, a->count * sizeof(int)) == 0));
+}
+
+//Doubles the size of the register of "b".
+void dawgGrowRegistry(dawgBuilder *b) {
+	uint64_t mask = b->registryMask * 2 + 1
+                ,index = 0
+                ,i = 0;
+	int *registry = malloc((mask + 1) * sizeof(int));
+
+	memset(registry, -1, (mask + 1) * sizeof(int));
+
+	for (i = 0; i <= b->registryMask; i++) {
+		if (b->registry[i] >= 0) {
+			index = dawgStateHash(&b->states[b->registry[i]]) & mask;
+
+			while (registry[index] >= 0) {
+				index = (index + 1) & mask;
+			}
+
+			registry[index] = b->registry[i];
+		}
+	}
+
+	free(b->registry);
+	b->registry = registry;
+	b->registryMask = mask;
+}
+
+//Returns the registered state equivalent to state "n", registering "n" itself if there isn't one.
+int dawgReplaceOrRegister(dawgBuilder *b, int n) {
+	uint64_t index = 0;
+
+	if ((b->registered + 1) * 2 > (int) (b->registryMask + 1)) {
+		dawgGrowRegistry(b);
+	}
+
+	index = dawgStateHash(&b->states[n]) & b->registryMask;
+
+	while (b->registry[index] >= 0) {
+		if (dawgStatesEqual(&b->states[b->registry[index]], &b->states[n])) {
+			return b->registry[index];
+		}
+
+		index = (index + 1) & b->registryMask;
+	}
+
+	b->registry[index] = n;
+	b->registered++;
+
+	return n;
+}
+
+//Freezes the states on the previous word's path deeper than "depth", replacing each with an equivalent registered state where there is one.
+void dawgMinimize(dawgBuilder *b, int depth) {
+	dawgState *parent = NULL;
+	int d = 0
+           ,child = 0
+           ,replacement = 0;
+
+	for (d = b->previousLength; d > depth; d--) {
+		child = b->path[d];
+		replacement = dawgReplaceOrRegister(b, child);
+
+		if (replacement != child) {
+			//The child was the last thing added to its parent, so it is always the parent's last transition.
+			parent = &b->states[b->path[d - 1]];
+			parent->targets[parent->count - 1] = replacement;
+			free(b->states[child].labels);
+			free(b->states[child].targets);
+			b->states[child].labels = NULL;
+			b->states[child].targets = NULL;
+			b->states[child].count = -1;
+		}
+	}
+}
+
+//Sets up an empty builder with just the start state.
+void dawgInit(dawgBuilder *b) {
+	b->stateCapacity = 1024;
+	b->stateCount = 0;
+	b->states = malloc(b->stateCapacity * sizeof(dawgState));
+	b->registryMask = 1023;
+	b->registered = 0;
+	b->registry = malloc((b->registryMask + 1) * sizeof(int));
+	memset(b->registry, -1, (b->registryMask + 1) * sizeof(int));
+	b->pathCapacity = 64;
+	b->path = malloc(b->pathCapacity * sizeof(int));
+	b->previous = malloc(b->pathCapacity);
+	b->previousLength = 0;
+	b->path[0] = dawgNewState(b);
+}
+
+//Adds "word" to the automaton. Words must be added in strictly increasing order.
+void dawgAddWord(dawgBuilder *b, char *word) {
+	int length = strlen(word)
+           ,prefix = 0
+           ,d = 0;
+
+	while (prefix < length && prefix < b->previousLength && word[prefix] == b->previous[prefix]) {
+		prefix++;
+	}
+
+	dawgMinimize(b, prefix);
+
+	if (length + 1 > b->pathCapacity) {
+		b->pathCapacity = (length + 1) * 2;
+		b->path = realloc(b->path, b->pathCapacity * sizeof(int));
+		b->previous = realloc(b->previous, b->pathCapacity);
+	}
+
+	for (d = prefix; d < length; d++) {
+		b->path[d + 1] = dawgNewState(b);
+		dawgAddTransition(b, b->path[d], word[d], b->path[d + 1]);
+	}
+
+	b->states[b->path[length]].final = 1;
+	memcpy(b->previous, word, length);
+	b->previousLength = length;
+}
+
+/*
+ * Serialized DAWG layout: a header, then for each state the index of its first transition with the final flag in the top bit (plus one extra entry
+ * marking the end of the last state's transitions), then every transition's target state, then every transition's label. State 0 is the start state.
+ */
+
+#define DAWG_MAGIC 0x67647370 //"psdg"
+#define DAWG_VERSION 1
+#define DAWG_FINAL 0x80000000U
+
+typedef struct DawgHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t stateCount;
+	uint32_t transitionCount;
+} dawgHeader;
+
+//Finishes building "b" and returns it serialized in a malloc'd buffer, storing the buffer's size in "size". "b" is freed.
+void* dawgSerialize(dawgBuilder *b, size_t *size) {
+	dawgHeader *h = NULL;
+	uint32_t *states = NULL
+                ,*targets = NULL;
+	unsigned char *labels = NULL;
+	int *numbers = malloc(b->stateCount * sizeof(int))
+           ,*order = malloc(b->stateCount * sizeof(int))
+           ,liveStates = 0
+           ,transitions = 0
+           ,head = 0
+           ,i = 0
+           ,j = 0;
+	dawgState *state = NULL;
+
+	dawgMinimize(b, 0);
+	dawgReplaceOrRegister(b, 0);
+
+	//Number the live states breadth first from the start state, so the start state is 0 and the dead ones are dropped.
+	for (i = 0; i < b->stateCount; i++) {
+		numbers[i] = -1;
+	}
+
+	numbers[0] = 0;
+	order[liveStates++] = 0;
+
+	for (head = 0; head < liveStates; head++) {
+		state = &b->states[order[head]];
+		transitions += state->count;
+
+		for (j = 0; j < state->count; j++) {
+			if (numbers[state->targets[j]] < 0) {
+				numbers[state->targets[j]] = liveStates;
+				order[liveStates++] = state->targets[j];
+			}
+		}
+	}
+
+	*size = sizeof(dawgHeader) + (liveStates + 1) * sizeof(uint32_t) + transitions * (sizeof(uint32_t) + 1);
+	h = malloc(*size);
+	h->magic = DAWG_MAGIC;
+	h->version = DAWG_VERSION;
+	h->stateCount = liveStates;
+	h->transitionCount = transitions;
+	states = (uint32_t *) (h + 1);
+	targets = states + liveStates + 1;
+	labels = (unsigned char *) (targets + transitions);
+	transitions = 0;
+
+	for (i = 0; i < liveStates; i++) {
+		state = &b->states[order[i]];
+		states[i] = transitions | (state->final ? DAWG_FINAL : 0);
+
+		for (j = 0; j < state->count; j++) {
+			targets[transitions] = numbers[state->targets[j]];
+			labels[transitions] = state->labels[j];
+			transitions++;
+		}
+	}
+
+	states[liveStates] = transitions;
+
+	for (i = 0; i < b->stateCount; i++) {
+		free(b->states[i].labels);
+		free(b->states[i].targets);
+	}
+
+	free(b->states);
+	free(b->registry);
+	free(b->path);
+	free(b->previous);
+	free(numbers);
+	free(order);
+
+	return h;
+}
+
+//A serialized DAWG, typically mapped straight from a file.
+typedef struct Dawg {
+	dawgHeader *header;
+	uint32_t *states;
+	uint32_t *targets;
+	unsigned char *labels;
+} dawg;
+
+//Points "d" into the serialized DAWG of "size" bytes at "bytes". Returns 1 if it is valid, or 0 otherwise.
+int dawgOpen(dawg *d, void *bytes, size_t size) {
+	d->header = bytes;
+
+	if (size < sizeof(dawgHeader) || d->header->magic != DAWG_MAGIC || d->header->version != DAWG_VERSION
+	    || size != sizeof(dawgHeader) + (d->header->stateCount + 1) * (uint64_t) sizeof(uint32_t) + d->header->transitionCount * (uint64_t) (sizeof(uint32_t) + 1)) {
+		return 0;
+	}
+
+	d->states = (uint32_t *) (d->header + 1);
+	d->targets = d->states + d->header->stateCount + 1;
+	d->labels = (unsigned char *) (d->targets + d->header->transitionCount);
+
+	return 1;
+}
+
+//Returns the state reached from "state" on "label", or -1 if there is no such transition.
+long dawgStep(dawg *d, uint32_t state, unsigned char label) {
+	uint32_t low = d->states[state] & ~DAWG_FINAL
+                ,high = d->states[state + 1] & ~DAWG_FINAL
+                ,middle = 0;
+
+	while (low < high) {
+		middle = (low + high) / 2;
+
+		if (d->labels[middle] == label) {
+			return d->targets[middle];
+		} else if (d->labels[middle] < label) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+
+	return -1;
+}
+
+//Returns the state reached from the start state by the first "length" letters of "prefix", or -1 if no word starts with them.
+long dawgWalk(dawg *d, char *prefix, int length) {
+	long state = 0;
+	int i = 0;
+
+	for (i = 0; i < length && state >= 0; i++) {
+		state = dawgStep(d, state, prefix[i]);
+	}
+
+	return state;
+}
+
+//Returns 1 if the first "length" letters of "word" are a word in the DAWG "d", or 0 otherwise.
+int dawgContains(dawg *d, char *word, int length) {
+	long state = dawgWalk(d, word, length);
+
+	return state >= 0 && (d->states[state] & DAWG_FINAL) != 0;
+}
+
+//Calls "visit" on every word reachable from "state" in sorted order. "buffer" holds the first "length" letters of those words.
+void dawgEnumerateFrom(dawg *d, uint32_t state, char *buffer, int length, void (*visit)(char *word, int wordLength, void *context), void *context) {
+	uint32_t i = 0;
+
+	if (d->states[state] & DAWG_FINAL) {
+		visit(buffer, length, context);
+	}
+
+	for (i = d->states[state] & ~DAWG_FINAL; i < (d->states[state + 1] & ~DAWG_FINAL); i++) {
+		buffer[length] = d->labels[i];
+		dawgEnumerateFrom(d, d->targets[i], buffer, length + 1, visit, context);
+	}
+}
+
+//Calls "visit" on every word in the DAWG "d" starting with the first "length" letters of "prefix", in sorted order.
+void dawgEnumerate(dawg *d, char *prefix, int length, void (*visit)(char *word, int wordLength, void *context), void *context) {
+	long state = dawgWalk(d, prefix, length);
+	char *buffer = NULL;
+
+	if (state < 0) {
+		return;
+	}
+
+	//No word can be longer than the number of states, since the automaton has no cycles.
+	buffer = malloc(length + d->header->stateCount + 1);
+	memcpy(buffer, prefix, length);
+	dawgEnumerateFrom(d, state, buffer, length, visit, context);
+	free(buffer);
+}
+
+//Word visitor which prints the word on its own line.
+void printVisitor(char *word, int wordLength, void *context) {
+	(void) context;
+	printf("%.*s\n", wordLength, word);
+}
+
+//Word visitor which prints the word and whether it is in the DAWG pointed to by "context".
+void dawgQueryVisitor(char *word, int wordLength, void *context) {
+	printf("%.*s %d\n", wordLength, word, dawgContains(context, word, wordLength));
+}
+
+//Word visitor which prints every word in the DAWG pointed to by "context" that starts with the visited word.
+void dawgPrefixVisitor(char *word, int wordLength, void *context) {
+	dawgEnumerate(context, word, wordLength, printVisitor, NULL);
+}
+
+//Builds the minimal DAWG of "count" sorted words and writes it to "path". Returns 0 on success or -1 on error.
+int writeDawg(char *path, char **words, int count) {
+	dawgBuilder b;
+	void *bytes = NULL;
+	size_t size = 0;
+	int result = 0
+           ,i = 0;
+
+	dawgInit(&b);
+
+	for (i = 0; i < count; i++) {
+		dawgAddWord(&b, words[i]);
+	}
+
+	bytes = dawgSerialize(&b, &size);
+	result = writeFile(path, bytes, size);
+	free(bytes);
+
+	return result;
+}
+
+/*
+ * Succinct LOUDS trie for frozen vocabularies. The trie's shape is stored in level order as one bit string: each node contributes a 1 per child
+ * followed by a 0, after a leading "10" for a virtual parent of the root. With rank and select over those bits, a node's children are found
+ * without any pointers. Node k (1-based, the root is 1) is the k-th 1 bit, its children sit between the k-th and (k + 1)-th 0 bits, the child label
+ * of node k is labels[k - 2], and a second bit string marks which nodes end a word. That comes to a little over 10 bits per trie node.
+ */
+
+#define LOUDS_MAGIC 0x6f6c7370 //"pslo"
+#define LOUDS_VERSION 1
+
+//A bit string with a rank directory: ranks[i] is the number of 1 bits in words[0..i - 1].
+typedef struct BitVector {
+	uint64_t *words;
+	uint32_t *ranks;
+	uint64_t length; //In bits.
+	uint64_t wordCount;
+} bitVector;
+
+typedef struct LoudsHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t nodeCount;
+	uint64_t shapeBits;
+	uint64_t wordCount; //Number of vocabulary words, i.e. 1 bits in the terminal bit string.
+} loudsHeader;
+
+typedef struct LoudsTrie {
+	loudsHeader *header;
+	bitVector shape;
+	bitVector terminal;
+	unsigned char *labels;
+} loudsTrie;
+
+//Returns the number of 64-bit words needed for "bits" bits.
+uint64_t bitWords(uint64_t bits) {
+	return (bits + 63) / 64;
+}
+
+//Returns the number of 1 bits in "b" before position "i".
+uint64_t rank1(bitVector *b, uint64_t i) {
+	uint64_t word = i / 64
+                ,bit = i % 64;
+
+	if (bit == 0) {
+		return word < b->wordCount ? b->ranks[word] : b->ranks[b->wordCount];
+	}
+
+	return b->ranks[word] + __builtin_popcountll(b->words[word] & ((1ULL << bit) - 1));
+}
+
+//Returns the position of the k-th (1-based) 0 bit in "b".
+uint64_t select0(bitVector *b, uint64_t k) {
+	uint64_t low = 0
+                ,high = b->wordCount
+                ,middle = 0
+                ,bits = 0;
+
+	//Find the last word with fewer than k zeros before it.
+	while (low + 1 < high) {
+		middle = (low + high) / 2;
+
+		if (middle * 64 - b->ranks[middle] < k) {
+			low = middle;
+		} else {
+			high = middle;
+		}
+	}
+
+	k -= low * 64 - b->ranks[low];
+	bits = ~b->words[low];
+
+	while (--k > 0) {
+		bits &= bits - 1;
+	}
+
+	return low * 64 + __builtin_ctzll(bits);
+}
+
+//Fills in the rank directory of "b".
+void buildRanks(bitVector *b) {
+	uint64_t i = 0;
+
+	b->ranks[0] = 0;
+
+	for (i = 0; i < b->wordCount; i++) {
+		b->ranks[i + 1] = b->ranks[i] + __builtin_popcountll(b->words[i]);
+	}
+}
+
+//Returns the number of bytes a bit vector of "bits" bits takes when serialized: its words followed by its rank directory.
+uint64_t bitVectorSize(uint64_t bits) {
+	uint64_t size = bitWords(bits) * sizeof(uint64_t) + (bitWords(bits) + 1) * sizeof(uint32_t);
+
+	return (size + 7) & ~7ULL;
+}
+
+//Points "b" at a serialized bit vector of "bits" bits at "bytes" and returns the address just past it.
+char* openBitVector(bitVector *b, char *bytes, uint64_t bits) {
+	b->length = bits;
+	b->wordCount = bitWords(bits);
+	b->words = (uint64_t *) bytes;
+	b->ranks = (uint32_t *) (b->words + b->wordCount);
+
+	return bytes + bitVectorSize(bits);
+}
+
+//Grows the zeroed bit words at "words", of which there are "*capacity", until bit "i" fits. Returns the words, which may have moved.
+uint64_t* reserveBit(uint64_t *words, uint64_t *capacity, uint64_t i) {
+	while (i >= *capacity * 64) {
+		words = realloc(words, *capacity * 2 * sizeof(uint64_t));
+		memset(words + *capacity, 0, *capacity * sizeof(uint64_t));
+		*capacity *= 2;
+	}
+
+	return words;
+}
+
+//Sets bit "i" of the bit words at "words".
+void setBit(uint64_t *words, uint64_t i) {
+	words[i / 64] |= 1ULL << (i % 64);
+}
+
+//Returns bit "i" of "b".
+int getBit(bitVector *b, uint64_t i) {
+	return (b->words[i / 64] >> (i % 64)) & 1;
+}
+
+//A run of sorted words [first, last) which share a prefix of length "depth", i.e. one trie node waiting to be laid out.
+typedef struct WordRange {
+	int first;
+	int last;
+} wordRange;
+
+/*
+ * Builds the LOUDS trie of "count" sorted words and returns it serialized in a malloc'd buffer, storing the buffer's size in "size". The trie is laid
+ * out level by level: every node at one depth is a run of words sharing a prefix, and its children are that run split on the next letter. Sorted
+ * input means those runs, and so the children of each node, already come out in order.
+ */
+void* loudsSerialize(char **words, int count, size_t *size) {
+	loudsHeader *h = NULL;
+	bitVector shape
+                 ,terminal;
+	wordRange *level = malloc(sizeof(wordRange))
+                 ,*next = NULL;
+	unsigned char *labels = NULL;
+	uint64_t nodes = 1
+                ,capacity = 64
+                ,bits = 2
+                ,terminals = 0
+                ,levelStart = 0
+                ,shapeCapacity = 1024
+                ,terminalCapacity = 1024
+                ,*shapeWords = calloc(shapeCapacity, sizeof(uint64_t))
+                ,*terminalWords = calloc(terminalCapacity, sizeof(uint64_t));
+	int levelCount = 1
+           ,nextCount = 0
+           ,depth = 0
+           ,first = 0
+           ,i = 0;
+	char *ptr = NULL;
+
+	labels = malloc(capacity);
+	level[0].first = 0;
+	level[0].last = count;
+
+	//The virtual parent of the root.
+	setBit(shapeWords, 0);
+
+	while (levelCount > 0) {
+		next = malloc((levelCount * 52 + 1) * sizeof(wordRange));
+		nextCount = 0;
+		levelStart = nodes - levelCount;
+
+		for (i = 0; i < levelCount; i++) {
+			first = level[i].first;
+
+			//The node's own word, if it has one, is the shortest and so comes first.
+			if (first < level[i].last && words[first][depth] == '\0') {
+				terminalWords = reserveBit(terminalWords, &terminalCapacity, levelStart + i);
+				setBit(terminalWords, levelStart + i);
+				terminals++;
+				first++;
+			}
+
+			while (first < level[i].last) {
+				if (nodes - 1 >= capacity) {
+					capacity *= 2;
+					labels = realloc(labels, capacity);
+				}
+
+				labels[nodes - 1] = words[first][depth];
+				next[nextCount].first = first;
+
+				while (first < level[i].last && words[first][depth] == labels[nodes - 1]) {
+					first++;
+				}
+
+				next[nextCount].last = first;
+				nextCount++;
+				nodes++;
+				shapeWords = reserveBit(shapeWords, &shapeCapacity, bits);
+				setBit(shapeWords, bits++);
+			}
+
+			//Every node ends with a 0 bit, leaves included, so this needs room as much as the 1 bits do.
+			shapeWords = reserveBit(shapeWords, &shapeCapacity, bits);
+			bits++;
+		}
+
+		free(level);
+		level = next;
+		levelCount = nextCount;
+		depth++;
+	}
+
+	free(level);
+
+	//The copies below read whole words up to the last bit of each vector.
+	shapeWords = reserveBit(shapeWords, &shapeCapacity, bits);
+	terminalWords = reserveBit(terminalWords, &terminalCapacity, nodes);
+
+	*size = sizeof(loudsHeader) + bitVectorSize(bits) + bitVectorSize(nodes) + nodes;
+	h = calloc(1, *size);
+	h->magic = LOUDS_MAGIC;
+	h->version = LOUDS_VERSION;
+	h->nodeCount = nodes;
+	h->shapeBits = bits;
+	h->wordCount = terminals;
+
+	ptr = openBitVector(&shape, (char *) (h + 1), bits);
+	memcpy(shape.words, shapeWords, shape.wordCount * sizeof(uint64_t));
+	buildRanks(&shape);
+	ptr = openBitVector(&terminal, ptr, nodes);
+	memcpy(terminal.words, terminalWords, terminal.wordCount * sizeof(uint64_t));
+	buildRanks(&terminal);
+	memcpy(ptr, labels, nodes - 1);
+
+	free(shapeWords);
+	free(terminalWords);
+	free(labels);
+
+	return h;
+}
+
+//Points "t" into the serialized LOUDS trie of "size" bytes at "bytes". Returns 1 if it is valid, or 0 otherwise.
+int loudsOpen(loudsTrie *t, void *bytes, size_t size) {
+	char *ptr = NULL;
+
+	t->header = bytes;
+
+	if (size < sizeof(loudsHeader) || t->header->magic != LOUDS_MAGIC || t->header->version != LOUDS_VERSION
+	    || size != sizeof(loudsHeader) + bitVectorSize(t->header->shapeBits) + bitVectorSize(t->header->nodeCount) + t->header->nodeCount) {
+		return 0;
+	}
+
+	ptr = openBitVector(&t->shape, (char *) (t->header + 1), t->header->shapeBits);
+	ptr = openBitVector(&t->terminal, ptr, t->header->nodeCount);
+	t->labels = (unsigned char *) ptr;
+
+	return 1;
+}
+
+//Stores the node numbers of the first and one past the last child of node "k" in "first" and "last".
+void loudsChildren(loudsTrie *t, uint64_t k, uint64_t *first, uint64_t *last) {
+	uint64_t start = select0(&t->shape, k) + 1
+                ,end = select0(&t->shape, k + 1);
+
+	*first = rank1(&t->shape, start) + 1;
+	*last = *first + (end - start);
+}
+
+//Returns the child of node "k" with label "label", or 0 if there is none.
+uint64_t loudsStep(loudsTrie *t, uint64_t k, unsigned char label) {
+	uint64_t low = 0
+                ,high = 0
+                ,middle = 0;
+
+	loudsChildren(t, k, &low, &high);
+
+	while (low < high) {
+		middle = (low + high) / 2;
+
+		if (t->labels[middle - 2] == label) {
+			return middle;
+		} else if (t->labels[middle - 2] < label) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+
+	return 0;
+}
+
+//Returns the node reached by the first "length" letters of "prefix", or 0 if no word starts with them.
+uint64_t loudsWalk(loudsTrie *t, char *prefix, int length) {
+	uint64_t k = 1;
+	int i = 0;
+
+	for (i = 0; i < length && k != 0; i++) {
+		k = loudsStep(t, k, prefix[i]);
+	}
+
+	return k;
+}
+
+//Returns 1 if the first "length" letters of "word" are a word in trie "t", or 0 otherwise.
+int loudsContains(loudsTrie *t, char *word, int length) {
+	uint64_t k = loudsWalk(t, word, length);
+
+	return k != 0 && getBit(&t->terminal, k - 1);
+}
+
+//Returns the number of words in trie "t" that start with the first "length" letters of "prefix".
+uint64_t loudsPrefixCount(loudsTrie *t, char *prefix, int length) {
+	uint64_t first = loudsWalk(t, prefix, length)
+                ,last = first + 1
+                ,childFirst = 0
+                ,childLast = 0
+                ,count = 0;
+
+	if (first == 0) {
+		return 0;
+	}
+
+	//A subtree's nodes on any one level are contiguous, so count the words ending on each level and step down to the next level's range.
+	while (first < last) {
+		count += rank1(&t->terminal, last - 1) - rank1(&t->terminal, first - 1);
+		loudsChildren(t, first, &childFirst, &childLast);
+		first = childFirst;
+		loudsChildren(t, last - 1, &childFirst, &childLast);
+		last = childLast;
+	}
+
+	return count;
+}
+
+//Calls "visit" on every word at or below node "k" in sorted order. "buffer" holds the first "length" letters of those words.
+void loudsEnumerateFrom(loudsTrie *t, uint64_t k, char *buffer, int length, void (*visit)(char *word, int wordLength, void *context), void *context) {
+	uint64_t first = 0
+                ,last = 0;
+
+	if (getBit(&t->terminal, k - 1)) {
+		visit(buffer, length, context);
+	}
+
+	loudsChildren(t, k, &first, &last);
+
+	for (; first < last; first++) {
+		buffer[length] = t->labels[first - 2];
+		loudsEnumerateFrom(t, first, buffer, length + 1, visit, context);
+	}
+}
+
+//Calls "visit" on every word in trie "t" in sorted order.
+void loudsEnumerate(loudsTrie *t, void (*visit)(char *word, int wordLength, void *context), void *context) {
+	char *buffer = malloc(t->header->nodeCount + 1);
+
+	loudsEnumerateFrom(t, 1, buffer, 0, visit, context);
+	free(buffer);
+}
+
+//Word visitor which prints the word, whether it is in the trie pointed to by "context", and how many words in the trie start with it.
+void loudsQueryVisitor(char *word, int wordLength, void *context) {
+	printf("%.*s %d %llu\n", wordLength, word, loudsContains(context, word, wordLength), (unsigned long long) loudsPrefixCount(context, word, wordLength));
+}
+
+//Builds the LOUDS trie of "count" sorted words and writes it to "path". Returns 0 on success or -1 on error.
+int writeLouds(char *path, char **words, int count) {
+	size_t size = 0;
+	void *bytes = loudsSerialize(words, count, &size);
+	int result = writeFile(path, bytes, size);
+
+	free(bytes);
+
+	return result;
+}
+
+/*
+ * Word streams tokenize text that arrives in pieces, such as reads from a file or a pipe. A word cut off at the end of one piece is held back and
+ * joined with the start of the next, so every word is visited exactly once, whole.
+ */
+
+typedef struct WordStream {
+	char *carry; //Letters at the end of the last piece which may continue in the next one.
+	int carryLength;
+	int carryCapacity;
+	void (*visit)(char *word, int wordLength, void *context);
+	void *context;
+} wordStream;
+
+//Sets up an empty word stream which passes its words to "visit".
+void streamInit(wordStream *stream, void (*visit)(char *word, int wordLength, void *context), void *context) {
+	stream->carry = NULL;
+	stream->carryLength = 0;
+	stream->carryCapacity = 0;
+	stream->visit = visit;
+	stream->context = context;
+}
+
+//Appends "length" letters at "letters" to the carry of "stream".
+void streamCarry(wordStream *stream, char *letters, int length) {
+	if (stream->carryLength + length > stream->carryCapacity) {
+		stream->carryCapacity = (stream->carryLength + length) * 2;
+		stream->carry = realloc(stream->carry, stream->carryCapacity + 1);
+	}
+
+	memcpy(stream->carry + stream->carryLength, letters, length);
+	stream->carryLength += length;
+	stream->carry[stream->carryLength] = '\0';
+}
+
+//Tokenizes the next "length" bytes of the stream.
+void streamFeed(wordStream *stream, char *bytes, int length) {
+	int start = 0
+           ,end = length;
+
+	//Finish off the word left over from the last piece first.
+	while (start < length && isalpha(bytes[start])) {
+		start++;
+	}
+
+	if (stream->carryLength > 0 || start > 0) {
+		streamCarry(stream, bytes, start);
+
+		if (start == length) {
+			return;
+		}
+
+		stream->visit(stream->carry, stream->carryLength, stream->context);
+		stream->carryLength = 0;
+	}
+
+	//Hold back the letters at the very end, since the word may go on in the next piece.
+	while (end > start && isalpha(bytes[end - 1])) {
+		end--;
+	}
+
+	forEachWord(bytes + start, end - start, stream->visit, stream->context);
+	streamCarry(stream, bytes + end, length - end);
+}
+
+//Visits the word held back at the end of the stream, if there is one, and frees the stream.
+void streamFinish(wordStream *stream) {
+	if (stream->carryLength > 0) {
+		stream->visit(stream->carry, stream->carryLength, stream->context);
+	}
+
+	free(stream->carry);
+	streamInit(stream, stream->visit, stream->context);
+}
+
+/*
+ * Follow mode. The file is tokenized up to its end once, and after that only bytes appended past the remembered offset are read, whenever inotify
+ * reports a change. A file that shrinks is read again from its start, and one that is rotated away is replaced by the new file under its name.
+ * The sorted vocabulary is written out again on SIGUSR1, every "interval" seconds if one is set, and once more on exit.
+ */
+
+volatile sig_atomic_t followSnapshot = 0
+                     ,followStop = 0;
+
+//Signal handler which asks the follow loop to write a snapshot (SIGUSR1) or to stop (anything else).
+void followSignal(int signal) {
+	if (signal == SIGUSR1) {
+		followSnapshot = 1;
+	} else {
+		followStop = 1;
+	}
+}
+
+//Writes the sorted words of the tree with root node "root" to "path", replacing it atomically, or to standard output if "path" is NULL.
+int writeSnapshot(node *root, char *path) {
+	formatJob job;
+	char *temporary = NULL;
+	int result = 0;
+
+	job.first = 0;
+	job.last = countNodes(root);
+	job.words = malloc((job.last + 1) * sizeof(char *));
+	flattenTree(root, job.words, 0);
+	formatRange(&job);
+
+	if (path == NULL) {
+		result = writeAll(STDOUT_FILENO, job.buffer, job.length, -1);
+	} else {
+		//Readers should never see a half-written snapshot, so write next to it and rename over it.
+		temporary = malloc(strlen(path) + 5);
+		sprintf(temporary, "%s.tmp", path);
+		result = writeFile(temporary, job.buffer, job.length);
+
+		if (result == 0 && rename(temporary, path) != 0) {
+			result = -1;
+		}
+
+		free(temporary);
+	}
+
+	free(job.buffer);
+	free(job.words);
+
+	return result;
+}
+
+//Reads whatever has been appended to "fd" past "*offset" into "stream" and moves "*offset" past it. A file that shrank is read again from the start.
+void followRead(int fd, off_t *offset, wordStream *stream) {
+	char buffer[65536];
+	struct stat info;
+	ssize_t length = 0;
+
+	if (fstat(fd, &info) == 0 && info.st_size < *offset) {
+		streamFinish(stream);
+		*offset = 0;
+	}
+
+	while ((length = pread(fd, buffer, sizeof(buffer), *offset)) > 0) {
+		streamFeed(stream, buffer, length);
+		*offset += length;
+	}
+}
+
+//Returns the monotonic clock in milliseconds.
+long long monotonicMilliseconds(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (long long) now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/*
+ * Follows the file "path", inserting its words through "visit" into the tree whose root is pointed to by "root". Returns 0 on success or -1 on error.
+ * The file itself is watched for writes, and its directory for a new file appearing under the same name, which is how rotation by renaming shows up.
+ * The old file is read to its end, and then the new one is followed from its start.
+ */
+int follow(char *path, int interval, char *snapshotPath, void (*visit)(char *word, int wordLength, void *context), void *context, node **root) {
+	struct sigaction action;
+	struct pollfd watch;
+	struct inotify_event *event = NULL;
+	struct timespec timeout;
+	sigset_t blocked
+                ,unblocked;
+	char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))))
+            ,*directory = strdup(path)
+            ,*name = strrchr(path, '/')
+            ,*ptr = NULL;
+	wordStream stream;
+	off_t offset = 0;
+	long long deadline = 0
+                 ,remaining = 0;
+	ssize_t length = 0;
+	int fd = open(path, O_RDONLY)
+           ,fileWatch = 0
+           ,rotated = 0
+           ,result = 0
+           ,ready = 0;
+
+	//Split the path into its directory and name; a bare name lives in the current directory.
+	if (name == NULL) {
+		strcpy(directory, ".");
+		name = path;
+	} else {
+		directory[name - path == 0 ? 1 : name - path] = '\0';
+		name++;
+	}
+
+	watch.fd = inotify_init1(IN_NONBLOCK);
+	watch.events = POLLIN;
+	fileWatch = fd < 0 || watch.fd < 0 ? -1 : inotify_add_watch(watch.fd, path, IN_MODIFY | IN_MOVE_SELF | IN_DELETE_SELF);
+
+	if (fd < 0 || fileWatch < 0 || inotify_add_watch(watch.fd, directory, IN_CREATE | IN_MOVED_TO) < 0) {
+		printf("Could not follow %s.\n", path);
+
+		if (fd >= 0) {
+			close(fd);
+		}
+
+		if (watch.fd >= 0) {
+			close(watch.fd);
+		}
+
+		free(directory);
+		return -1;
+	}
+
+	/*
+	 * The signals stay blocked except while waiting in ppoll, so one can't slip in between checking the flags and going to sleep. No SA_RESTART
+	 * either, so a signal wakes the wait straight away.
+	 */
+	sigemptyset(&blocked);
+	sigaddset(&blocked, SIGUSR1);
+	sigaddset(&blocked, SIGINT);
+	sigaddset(&blocked, SIGTERM);
+	sigprocmask(SIG_BLOCK, &blocked, &unblocked);
+
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = followSignal;
+	sigaction(SIGUSR1, &action, NULL);
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+
+	streamInit(&stream, visit, context);
+	followRead(fd, &offset, &stream);
+
+	//Snapshots are due every "interval" seconds by the clock, however busy the file is.
+	deadline = monotonicMilliseconds() + interval * 1000LL;
+
+	while (!followStop) {
+		if (interval > 0) {
+			remaining = deadline - monotonicMilliseconds();
+			remaining = remaining < 0 ? 0 : remaining;
+			timeout.tv_sec = remaining / 1000;
+			timeout.tv_nsec = remaining % 1000 * 1000000;
+		}
+
+		ready = ppoll(&watch, 1, interval > 0 ? &timeout : NULL, &unblocked);
+
+		if (ready > 0) {
+			while ((length = read(watch.fd, events, sizeof(events))) > 0) {
+				for (ptr = events; ptr < events + length; ptr += sizeof(struct inotify_event) + event->len) {
+					event = (struct inotify_event *) ptr;
+
+					if (event->wd != fileWatch && event->len > 0 && strcmp(event->name, name) == 0) {
+						rotated = 1;
+					}
+				}
+			}
+
+			followRead(fd, &offset, &stream);
+
+			//A new file took the old one's name: the old one has just been read to its end, so carry on with the new one from its start.
+			if (rotated) {
+				rotated = 0;
+				streamFinish(&stream);
+				inotify_rm_watch(watch.fd, fileWatch);
+				close(fd);
+				fd = open(path, O_RDONLY);
+				offset = 0;
+
+				if (fd < 0) {
+					printf("Could not reopen %s.\n", path);
+					result = -1;
+					break;
+				}
+
+				fileWatch = inotify_add_watch(watch.fd, path, IN_MODIFY | IN_MOVE_SELF | IN_DELETE_SELF);
+				followRead(fd, &offset, &stream);
+			}
+		}
+
+		if (interval > 0 && monotonicMilliseconds() >= deadline) {
+			followSnapshot = 1;
+			deadline = monotonicMilliseconds() + interval * 1000LL;
+		}
+
+		if (followSnapshot) {
+			followSnapshot = 0;
+
+			if (writeSnapshot(*root, snapshotPath) != 0) {
+				result = -1;
+			}
+		}
+	}
+
+	streamFinish(&stream);
+
+	if (writeSnapshot(*root, snapshotPath) != 0) {
+		result = -1;
+	}
+
+	sigprocmask(SIG_SETMASK, &unblocked, NULL);
+	close(watch.fd);
+
+	if (fd >= 0) {
+		close(fd);
+	}
+
+	free(directory);
+
+	return result;
+}
+
+/*
+ * Input files. A reader thread decompresses the file (gzip or zstd, recognized by their magic bytes, or plain text otherwise) into a ring of
+ * fixed-size blocks, while the calling thread takes the blocks in order and tokenizes them, so decompression overlaps with building the tree.
+ */
+
+#define INPUT_BLOCK (1 << 16)
+#define INPUT_BLOCKS 8
+
+typedef struct InputRing {
+	char blocks[INPUT_BLOCKS][INPUT_BLOCK];
+	int lengths[INPUT_BLOCKS];
+	long filled; //Blocks ever filled by the reader. Block i lives in slot i % INPUT_BLOCKS.
+	long taken; //Blocks ever handed back by the consumer.
+	int done;
+	int failed;
+	int fd;
+	pthread_mutex_t lock;
+	pthread_cond_t changed;
+} inputRing;
+
+//Decompression state of one input file.
+typedef struct InputDecoder {
+	int fd;
+	char format; //g for gzip, z for zstd, anything else for plain text.
+	int finished;
+	unsigned char *buffer; //Compressed bytes read but not yet decompressed.
+	size_t length;
+	size_t position;
+	z_stream gzip;
+#ifdef HAVE_ZSTD
+	ZSTD_DStream *zstd;
+	size_t pending; //What the last zstd call that got anywhere returned, which is 0 only at the end of a frame.
+#endif
+} inputDecoder;
+
+//Refills the compressed buffer of "d". Returns the number of new bytes, 0 at the end of the file, or -1 on error.
+ssize_t decoderRead(inputDecoder *d) {
+	ssize_t length = 0;
+
+	do {
+		length = read(d->fd, d->buffer, INPUT_BLOCK);
+	} while (length < 0 && errno == EINTR);
+
+	d->length = length > 0 ? length : 0;
+	d->position = 0;
+
+	return length;
+}
+
+//Fills "block" with up to "size" bytes of decompressed input. Returns the number of bytes, 0 at the end of the input, or -1 on error.
+int decoderFill(inputDecoder *d, char *block, int size) {
+	ssize_t length = 0;
+	int status = 0;
+#ifdef HAVE_ZSTD
+	ZSTD_inBuffer in;
+	ZSTD_outBuffer out;
+	size_t hint = 0
+              ,before = 0;
+	int ended = 0;
+#endif
+
+	if (d->format == 'g') {
+		d->gzip.next_out = (unsigned char *) block;
+		d->gzip.avail_out = size;
+
+		while (d->gzip.avail_out > 0 && !d->finished) {
+			if (d->gzip.avail_in == 0) {
+				length = decoderRead(d);
+
+				if (length < 0) {
+					return -1;
+				}
+
+				//The file ended in the middle of a member.
+				if (length == 0) {
+					return -1;
+				}
+
+				d->gzip.next_in = d->buffer;
+				d->gzip.avail_in = length;
+			}
+
+			status = inflate(&d->gzip, Z_NO_FLUSH);
+
+			//Concatenated gzip members are one stream to gunzip, so carry on with the next member if there is more input.
+			if (status == Z_STREAM_END) {
+				if (d->gzip.avail_in == 0) {
+					length = decoderRead(d);
+
+					if (length < 0) {
+						return -1;
+					}
+
+					d->gzip.next_in = d->buffer;
+					d->gzip.avail_in = length;
+				}
+
+				if (d->gzip.avail_in == 0) {
+					d->finished = 1;
+				} else {
+					inflateReset(&d->gzip);
+				}
+			} else if (status != Z_OK && status != Z_BUF_ERROR) {
+				return -1;
+			}
+		}
+
+		return size - d->gzip.avail_out;
+	}
+
+#ifdef HAVE_ZSTD
+	if (d->format == 'z') {
+		out.dst = block;
+		out.size = size;
+		out.pos = 0;
+
+		while (out.pos < out.size && !d->finished) {
+			if (d->position == d->length && !ended) {
+				length = decoderRead(d);
+
+				if (length < 0) {
+					return -1;
+				}
+
+				ended = length == 0;
+			}
+
+			in.src = d->buffer;
+			in.size = d->length;
+			in.pos = d->position;
+			before = out.pos;
+			hint = ZSTD_decompressStream(d->zstd, &out, &in);
+
+			if (ZSTD_isError(hint)) {
+				return -1;
+			}
+
+			//A call with nothing to do returns the size of the next frame's header instead, so only calls that got somewhere count.
+			if (in.pos != d->position || out.pos != before) {
+				d->pending = hint;
+			}
+
+			d->position = in.pos;
+
+			//Past the end of the file zstd can only flush what it still holds. Once that stops, the last frame was cut short unless it had ended.
+			if (ended && out.pos == before) {
+				if (d->pending != 0) {
+					return -1;
+				}
+
+				d->finished = 1;
+			}
+		}
+
+		return out.pos;
+	}
+#endif
+
+	do {
+		length = read(d->fd, block, size);
+	} while (length < 0 && errno == EINTR);
+
+	return length;
+}
+
+//Thread body which decompresses the file of the inputRing "arg" into its blocks until the input ends.
+void* fillRing(void *arg) {
+	inputRing *ring = arg;
+	inputDecoder d;
+	unsigned char magic[4] = {0, 0, 0, 0};
+	int slot = 0
+           ,length = 0;
+
+	memset(&d, 0, sizeof(d));
+	d.fd = ring->fd;
+	d.buffer = malloc(INPUT_BLOCK);
+
+	if (pread(d.fd, magic, sizeof(magic), 0) >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+		d.format = 'g';
+		inflateInit2(&d.gzip, 15 + 32);
+	} else if (magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) {
+		d.format = 'z';
+#ifdef HAVE_ZSTD
+		d.zstd = ZSTD_createDStream();
+		ZSTD_initDStream(d.zstd);
+		d.pending = 1;
+#else
+		//Built without libzstd, so the file can't be read.
+		length = -1;
+#endif
+	}
+
+	while (length >= 0) {
+		pthread_mutex_lock(&ring->lock);
+
+		while (ring->filled - ring->taken == INPUT_BLOCKS) {
+			pthread_cond_wait(&ring->changed, &ring->lock);
+		}
+
+		pthread_mutex_unlock(&ring->lock);
+
+		//The slot is the reader's alone until it is published, so it is filled outside the lock.
+		slot = ring->filled % INPUT_BLOCKS;
+		length = decoderFill(&d, ring->blocks[slot], INPUT_BLOCK);
+
+		if (length <= 0) {
+			break;
+		}
+
+		pthread_mutex_lock(&ring->lock);
+		ring->lengths[slot] = length;
+		ring->filled++;
+		pthread_cond_broadcast(&ring->changed);
+		pthread_mutex_unlock(&ring->lock);
+	}
+
+	pthread_mutex_lock(&ring->lock);
+	ring->failed = length < 0;
+	ring->done = 1;
+	pthread_cond_broadcast(&ring->changed);
+	pthread_mutex_unlock(&ring->lock);
+
+	if (d.format == 'g') {
+		inflateEnd(&d.gzip);
+	}
+
+#ifdef HAVE_ZSTD
+	if (d.format == 'z') {
+		ZSTD_freeDStream(d.zstd);
+	}
+#endif
+
+	free(d.buffer);
+
+	return NULL;
+}
+
+//Reads the file "path", decompressing it if needed, and passes it to "consume" one block at a time in order. Returns 0 on success or -1 on error.
+int readInput(char *path, void (*consume)(char *bytes, int length, void *context), void *context) {
+	inputRing *ring = malloc(sizeof(inputRing));
+	pthread_t reader;
+	int slot = 0
+           ,result = 0;
+
+	ring->fd = open(path, O_RDONLY);
+
+	if (ring->fd < 0) {
+		free(ring);
+		return -1;
+	}
+
+	ring->filled = 0;
+	ring->taken = 0;
+	ring->done = 0;
+	ring->failed = 0;
+	pthread_mutex_init(&ring->lock, NULL);
+	pthread_cond_init(&ring->changed, NULL);
+
+	//The reader blocks once the ring is full, so it can't just be run here instead.
+	if (pthread_create(&reader, NULL, fillRing, ring) != 0) {
+		close(ring->fd);
+		pthread_mutex_destroy(&ring->lock);
+		pthread_cond_destroy(&ring->changed);
+		free(ring);
+		return -1;
+	}
+
+	while (1) {
+		pthread_mutex_lock(&ring->lock);
+
+		while (ring->taken == ring->filled && !ring->done) {
+			pthread_cond_wait(&ring->changed, &ring->lock);
+		}
+
+		if (ring->taken == ring->filled) {
+			pthread_mutex_unlock(&ring->lock);
+			break;
+		}
+
+		pthread_mutex_unlock(&ring->lock);
+
+		slot = ring->taken % INPUT_BLOCKS;
+		consume(ring->blocks[slot], ring->lengths[slot], context);
+
+		pthread_mutex_lock(&ring->lock);
+		ring->taken++;
+		pthread_cond_broadcast(&ring->changed);
+		pthread_mutex_unlock(&ring->lock);
+	}
+
+	pthread_join(reader, NULL);
+	result = ring->failed ? -1 : 0;
+	close(ring->fd);
+	pthread_mutex_destroy(&ring->lock);
+	pthread_cond_destroy(&ring->changed);
+	free(ring);
+
+	return result;
+}
+
+//Block consumer which tokenizes the block through the wordStream pointed to by "context".
+void streamConsumer(char *bytes, int length, void *context) {
+	streamFeed(context, bytes, length);
+}
+
+//A growable, NUL-terminated byte buffer.
+typedef struct InputBuffer {
+	char *bytes;
+	size_t length;
+	size_t capacity;
+} inputBuffer;
+
+//Block consumer which appends the block to the inputBuffer pointed to by "context", for modes that need the whole input at once.
+void bufferConsumer(char *bytes, int length, void *context) {
+	inputBuffer *buffer = context;
+
+	if (buffer->length + length + 1 > buffer->capacity) {
+		buffer->capacity = (buffer->length + length + 1) * 2;
+		buffer->bytes = realloc(buffer->bytes, buffer->capacity);
+	}
+
+	memcpy(buffer->bytes + buffer->length, bytes, length);
+	buffer->length += length;
+	buffer->bytes[buffer->length] = '\0';
+}
+
+/*
+ * Distributed mode. The coordinator cuts the input into one slice per worker at word boundaries, picks splitters from words found at evenly spaced
+ * byte offsets, and sends each worker its slice along with the splitters and the list of workers. Each worker tokenizes its own slice, keeping the
+ * words in its own key range and streaming the rest over TCP straight to the workers that own them, while a thread per other worker inserts the
+ * words that worker sends. Once the coordinator and every other worker have hung up, each worker merges its trees and streams its sorted shard
+ * back to the coordinator. Because the key ranges are ordered, the coordinator only has to concatenate the shards in worker order; no word passes
+ * through it after the input has been sent.
+ */
+
+#define SAMPLE_SIZE 4096
+
+//Returns the offset of the first word at or after "offset" in the "length" bytes of "text", skipping the rest of a word "offset" is inside.
+size_t nextWordStart(char *text, size_t length, size_t offset) {
+	while (offset > 0 && offset < length && isalpha(text[offset - 1])) {
+		offset++;
+	}
+
+	while (offset < length && !isalpha(text[offset])) {
+		offset++;
+	}
+
+	return offset;
+}
+
+/*
+ * Picks the "workers - 1" splitters for the "length" bytes of "text" from the words at SAMPLE_SIZE evenly spaced offsets. They are evenly spaced
+ * order statistics of that sample, so each worker should get about the same share of the words. Returns them in a malloc'd array of malloc'd words.
+ */
+char** chooseSplitters(char *text, size_t length, int workers) {
+	char **sample = malloc(SAMPLE_SIZE * sizeof(char *))
+            ,**splitters = malloc(workers * sizeof(char *));
+	size_t start = 0
+              ,end = 0;
+	int count = 0
+           ,i = 0;
+
+	//Reading a word at each offset instead of tokenizing everything keeps the coordinator's work independent of the size of the input.
+	for (i = 0; i < SAMPLE_SIZE; i++) {
+		start = nextWordStart(text, length, length / SAMPLE_SIZE * i + length % SAMPLE_SIZE * i / SAMPLE_SIZE);
+
+		for (end = start; end < length && isalpha(text[end]); end++) {
+		}
+
+		if (end > start) {
+			sample[count++] = strndup(text + start, end - start);
+		}
+	}
+
+	qsort(sample, count, sizeof(char *), compareWords);
+
+	for (i = 1; i < workers; i++) {
+		splitters[i - 1] = strdup(count > 0 ? sample[(long) count * i / workers] : "");
+	}
+
+	for (i = 0; i < count; i++) {
+		free(sample[i]);
+	}
+
+	free(sample);
+
+	return splitters;
+}
+
+//Holds one buffered output stream per worker and the splitters that decide which worker owns a word. The words this worker owns go into "root".
+typedef struct Shuffle {
+	FILE **streams; //NULL for this worker itself.
+	char **splitters; //Worker i owns the words w with splitters[i - 1] <= w < splitters[i].
+	int workers;
+	node *root;
+} shuffle;
+
+//Word visitor which keeps the word or sends it to the worker that owns it, for the shuffle pointed to by "context".
+void shuffleVisitor(char *word, int wordLength, void *context) {
+	shuffle *s = context;
+	char saved = word[wordLength];
+	int low = 0
+           ,high = s->workers - 1
+           ,middle = 0;
+
+	//Binary search the splitters for the first one greater than the word. The input is temporarily terminated so strcmp can be used.
+	word[wordLength] = '\0';
+
+	while (low < high) {
+		middle = (low + high) / 2;
+
+		if (strcmp(word, s->splitters[middle]) < 0) {
+			high = middle;
+		} else {
+			low = middle + 1;
+		}
+	}
+
+	word[wordLength] = saved;
+
+	if (s->streams[low] == NULL) {
+		insertVisitor(word, wordLength, &s->root);
+	} else {
+		fwrite(word, 1, wordLength, s->streams[low]);
+		fputc('\n', s->streams[low]);
+	}
+}
+
+//Connects to "hostPort", given as host:port. Returns the connected socket or -1 on error.
+int connectTo(char *hostPort) {
+	struct addrinfo hints, *addresses = NULL, *address = NULL;
+	char *host = strdup(hostPort)
+            ,*port = strrchr(host, ':');
+	int sock = -1;
+
+	if (port == NULL) {
+		free(host);
+		return -1;
+	}
+
+	*port++ = '\0';
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+
+	if (getaddrinfo(host, port, &hints, &addresses) == 0) {
+		for (address = addresses; address != NULL && sock < 0; address = address->ai_next) {
+			sock = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+
+			if (sock >= 0 && connect(sock, address->ai_addr, address->ai_addrlen) != 0) {
+				close(sock);
+				sock = -1;
+			}
+		}
+
+		freeaddrinfo(addresses);
+	}
+
+	free(host);
+
+	return sock;
+}
+
+//Copies everything readable from "from" to "to" until end of file. Returns 0 on success or -1 on error.
+int copyStream(int from, int to) {
+	char buffer[65536];
+	ssize_t length = 0;
+
+	while ((length = read(from, buffer, sizeof(buffer))) != 0) {
+		if (length < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			return -1;
+		}
+
+		if (writeAll(to, buffer, length, -1) != 0) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+//One worker's slice of the input and the header sent ahead of it.
+typedef struct SliceJob {
+	int sock;
+	char *header;
+	size_t headerLength;
+	char *text;
+	size_t length;
+	int result;
+} sliceJob;
+
+//Thread body which sends a worker its header and slice, then hangs up the sending side so the worker knows it has all of the slice.
+void* sendSlice(void *arg) {
+	sliceJob *job = arg;
+
+	job->result = writeAll(job->sock, job->header, job->headerLength, -1) == 0 && writeAll(job->sock, job->text, job->length, -1) == 0 ? 0 : -1;
+	shutdown(job->sock, SHUT_WR);
+
+	return NULL;
+}
+
+/*
+ * Runs the coordinator for the comma-separated host:port list "workerList" over the input "text". Each worker is sent a line with its index and the
+ * number of workers, a line per worker with its host:port, a line per splitter, and then its slice of the input. Returns 0 on success or -1 on error.
+ */
+int coordinate(char *text, size_t length, char *workerList) {
+	sliceJob *jobs = NULL;
+	pthread_t *senders = NULL;
+	char *list = strdup(workerList)
+            ,**hosts = NULL
+            ,**splitters = NULL
+            ,*tail = NULL;
+	size_t tailLength = 0
+              ,start = 0
+              ,end = 0;
+	int workers = 1
+           ,connected = 0
+           ,result = 0
+           ,i = 0;
+
+	for (i = 0; list[i] != '\0'; i++) {
+		if (list[i] == ',') {
+			workers++;
+		}
+	}
+
+	jobs = malloc(workers * sizeof(sliceJob));
+	senders = malloc(workers * sizeof(pthread_t));
+	hosts = malloc(workers * sizeof(char *));
+
+	//Empty entries in the list leave strtok short of hosts.
+	for (i = 0; i < workers; i++) {
+		hosts[i] = strtok(i == 0 ? list : NULL, ",");
+	}
+
+	//Every worker is connected to before any is sent anything, so if one is unreachable the rest are hung up on without a header and give up.
+	for (connected = 0; connected < workers; connected++) {
+		jobs[connected].sock = hosts[connected] == NULL ? -1 : connectTo(hosts[connected]);
+
+		if (jobs[connected].sock < 0) {
+			printf("Could not connect to worker %s.\n", hosts[connected] != NULL ? hosts[connected] : "");
+			result = -1;
+			break;
+		}
+	}
+
+	if (result == 0) {
+		splitters = chooseSplitters(text, length, workers);
+
+		for (i = 0; i < workers; i++) {
+			tailLength += strlen(hosts[i]) + 1;
+		}
+
+		for (i = 0; i < workers - 1; i++) {
+			tailLength += strlen(splitters[i]) + 1;
+		}
+
+		tail = malloc(tailLength + 1);
+		tailLength = 0;
+
+		for (i = 0; i < workers; i++) {
+			tailLength += sprintf(tail + tailLength, "%s\n", hosts[i]);
+		}
+
+		for (i = 0; i < workers - 1; i++) {
+			tailLength += sprintf(tail + tailLength, "%s\n", splitters[i]);
+		}
+
+		//Slices end just after a non-letter, so no word is split between two workers. They are sent at the same time so the workers all start at once.
+		for (i = 0; i < workers; i++) {
+			end = i == workers - 1 ? length : length / workers * (i + 1) + length % workers * (i + 1) / workers;
+
+			while (end < length && end > start && isalpha(text[end - 1])) {
+				end++;
+			}
+
+			if (end < start) {
+				end = start;
+			}
+
+			jobs[i].header = malloc(tailLength + 32);
+			jobs[i].headerLength = snprintf(jobs[i].header, 32, "slice %d %d\n", i, workers);
+			memcpy(jobs[i].header + jobs[i].headerLength, tail, tailLength);
+			jobs[i].headerLength += tailLength;
+			jobs[i].text = text + start;
+			jobs[i].length = end - start;
+			startOrRun(&senders[i], sendSlice, &jobs[i]);
+			start = end;
+		}
+
+		for (i = 0; i < workers; i++) {
+			joinStarted(senders[i]);
+
+			if (jobs[i].result != 0) {
+				result = -1;
+			}
+
+			free(jobs[i].header);
+		}
+
+		for (i = 0; i < workers - 1; i++) {
+			free(splitters[i]);
+		}
+
+		free(splitters);
+		free(tail);
+	}
+
+	for (i = 0; i < connected; i++) {
+		if (result == 0 && copyStream(jobs[i].sock, STDOUT_FILENO) != 0) {
+			result = -1;
+		}
+
+		close(jobs[i].sock);
+	}
+
+	free(jobs);
+	free(senders);
+	free(hosts);
+	free(list);
+
+	return result;
+}
+
+//Tokenizes everything read from "in" until end of file a block at a time. A word cut off at the end of a block waits for the rest of it. Returns 0
+//on success or -1 on a read error.
+int readWords(FILE *in, void (*visit)(char *word, int wordLength, void *context), void *context) {
+	char *buffer = NULL;
+	size_t capacity = 65536
+              ,used = 0
+              ,length = 0
+              ,consumed = 0;
+
+	buffer = malloc(capacity);
+
+	while ((length = fread(buffer + used, 1, capacity - used, in)) > 0) {
+		used += length;
+
+		for (consumed = used; consumed > 0 && isalpha(buffer[consumed - 1]); consumed--) {
+		}
+
+		if (consumed > 0) {
+			forEachWord(buffer, consumed, visit, context);
+			memmove(buffer, buffer + consumed, used - consumed);
+			used -= consumed;
+		} else if (used == capacity) {
+			capacity *= 2;
+			buffer = realloc(buffer, capacity);
+		}
+	}
+
+	forEachWord(buffer, used, visit, context);
+	free(buffer);
+
+	return ferror(in) ? -1 : 0;
+}
+
+//One connection a worker reads words from: the coordinator's, carrying the worker's slice, or another worker's, carrying the words the worker owns.
+typedef struct WorkerLink {
+	FILE *in;
+	shuffle route; //Another worker's link has just one stream, which is NULL, so every word it sends is kept.
+	pthread_t thread;
+	int started;
+	int result;
+} workerLink;
+
+//Thread body which routes every word read from the workerLink "arg", then hangs up on the other workers it sent words to.
+void* readLink(void *arg) {
+	workerLink *link = arg;
+	int i = 0;
+
+	link->result = readWords(link->in, shuffleVisitor, &link->route);
+
+	for (i = 0; i < link->route.workers; i++) {
+		if (link->route.streams[i] != NULL && fclose(link->route.streams[i]) != 0) {
+			link->result = -1;
+		}
+	}
+
+	return NULL;
+}
+
+//Reads one line from "in" into a newly malloc'd string without its newline. Returns the string, or NULL at end of file.
+char* readLine(FILE *in) {
+	char *line = NULL;
+	size_t capacity = 0;
+	ssize_t length = getline(&line, &capacity, in);
+
+	if (length < 0) {
+		free(line);
+		return NULL;
+	}
+
+	if (length > 0 && line[length - 1] == '\n') {
+		line[length - 1] = '\0';
+	}
+
+	return line;
+}
+
+/*
+ * Reads the rest of the coordinator's header from "link" for worker "self" of "workers", and connects to every other worker so the link's words can
+ * be routed. Returns 0 on success or -1 on error.
+ */
+int joinPeers(workerLink *link, int self, int workers) {
+	char **hosts = calloc(workers, sizeof(char *));
+	int sock = -1
+           ,result = 0
+           ,i = 0;
+
+	link->route.workers = workers;
+	link->route.streams = calloc(workers, sizeof(FILE *));
+	link->route.splitters = calloc(workers, sizeof(char *));
+
+	for (i = 0; i < workers && result == 0; i++) {
+		hosts[i] = readLine(link->in);
+		result = hosts[i] == NULL ? -1 : 0;
+	}
+
+	for (i = 0; i < workers - 1 && result == 0; i++) {
+		link->route.splitters[i] = readLine(link->in);
+		result = link->route.splitters[i] == NULL ? -1 : 0;
+	}
+
+	//Each other worker is told which worker is sending before any words.
+	for (i = 0; i < workers && result == 0; i++) {
+		if (i == self) {
+			continue;
+		}
+
+		sock = connectTo(hosts[i]);
+		link->route.streams[i] = sock < 0 ? NULL : fdopen(sock, "w");
+
+		if (link->route.streams[i] == NULL) {
+			printf("Could not connect to worker %s.\n", hosts[i]);
+
+			if (sock >= 0) {
+				close(sock);
+			}
+
+			result = -1;
+		} else {
+			fprintf(link->route.streams[i], "peer %d\n", self);
+		}
+	}
+
+	for (i = 0; i < workers; i++) {
+		free(hosts[i]);
+	}
+
+	free(hosts);
+
+	return result;
+}
+
+//Runs a worker which serves one coordinator on "port", then exits. Returns 0 on success or -1 on error.
+int work(char *port) {
+	struct sockaddr_in address;
+	workerLink **links = NULL
+                  ,*link = NULL
+                  ,*coordinator = NULL;
+	node *root = NULL
+            ,*inserted = NULL;
+	formatJob job;
+	char *line = NULL
+            ,**words = NULL;
+	int listener = socket(AF_INET, SOCK_STREAM, 0)
+           ,sock = -1
+           ,yes = 1
+           ,workers = 0
+           ,self = 0
+           ,peer = 0
+           ,linkCount = 0
+           ,count = 0
+           ,result = 0
+           ,i = 0
+           ,j = 0;
+
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	address.sin_port = htons(atoi(port));
+	setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+	if (listener < 0 || bind(listener, (struct sockaddr *) &address, sizeof(address)) != 0 || listen(listener, SOMAXCONN) != 0) {
+		printf("Could not listen on port %s.\n", port);
+		return -1;
+	}
+
+	/*
+	 * Other workers can connect before the coordinator does, so connections are taken until there is one from the coordinator and one from each
+	 * other worker, which makes one per worker. The first line of each says which it is. Every link is read on its own thread, since the words
+	 * coming in on one can't wait for another to finish.
+	 */
+	while (result == 0 && (coordinator == NULL || linkCount < workers)) {
+		sock = accept(listener, NULL, NULL);
+
+		if (sock < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			result = -1;
+			break;
+		}
+
+		link = calloc(1, sizeof(workerLink));
+		link->in = fdopen(sock, "r");
+		links = realloc(links, (linkCount + 1) * sizeof(workerLink *));
+		links[linkCount++] = link;
+
+		if (link->in == NULL) {
+			close(sock);
+			result = -1;
+			break;
+		}
+
+		line = readLine(link->in);
+
+		if (line != NULL && coordinator == NULL && sscanf(line, "slice %d %d", &self, &workers) == 2 && workers > 0 && self >= 0 && self < workers) {
+			coordinator = link;
+			result = joinPeers(link, self, workers);
+		} else if (line != NULL && sscanf(line, "peer %d", &peer) == 1) {
+			link->route.workers = 1;
+			link->route.streams = calloc(1, sizeof(FILE *));
+		} else {
+			result = -1;
+		}
+
+		free(line);
+
+		//Running a link here instead would stop the other links from being accepted, which can leave every worker waiting on another.
+		if (result == 0 && pthread_create(&link->thread, NULL, readLink, link) != 0) {
+			result = -1;
+		}
+
+		link->started = result == 0;
+	}
+
+	close(listener);
+
+	for (i = 0; i < linkCount; i++) {
+		if (links[i]->started) {
+			pthread_join(links[i]->thread, NULL);
+			result = links[i]->result != 0 ? -1 : result;
+		}
+	}
+
+	//Each link built its own tree, so their words are merged into one. The same word can arrive from several workers.
+	for (i = 0; i < linkCount && result == 0; i++) {
+		count = countNodes(links[i]->route.root);
+		words = malloc((count + 1) * sizeof(char *));
+		flattenTree(links[i]->route.root, words, 0);
+
+		for (j = 0; j < count; j++) {
+			root = insertNode(root, words[j], &inserted);
+
+			if (getWord(inserted) != words[j]) {
+				free(words[j]);
+			}
+		}
+
+		free(words);
+	}
+
+	if (result == 0) {
+		job.first = 0;
+		job.last = countNodes(root);
+		job.words = malloc((job.last + 1) * sizeof(char *));
+		flattenTree(root, job.words, 0);
+		formatRange(&job);
+		result = writeAll(fileno(coordinator->in), job.buffer, job.length, -1);
+		free(job.buffer);
+		free(job.words);
+	} else {
+		printf("Worker on port %s failed.\n", port);
+	}
+
+	for (i = 0; i < linkCount; i++) {
+		for (j = 0; j < links[i]->route.workers - 1; j++) {
+			free(links[i]->route.splitters[j]);
+		}
+
+		//Streams to other workers are closed by the link's thread, so only a link that never started still has them open.
+		for (j = 0; j < links[i]->route.workers && !links[i]->started; j++) {
+			if (links[i]->route.streams[j] != NULL) {
+				fclose(links[i]->route.streams[j]);
+			}
+		}
+
+		if (links[i]->in != NULL) {
+			fclose(links[i]->in);
+		}
+
+		recycleTree(links[i]->route.root);
+		free(links[i]->route.splitters);
+		free(links[i]->route.streams);
+		free(links[i]);
+	}
+
+	free(links);
+	recycleTree(root);
+
+	return result;
+}
+
+
+/*
+ * Merge mode. When every input file is already a sorted word list, like an earlier run's output, the lists are merged a word at a time through a
+ * heap of the files' current words instead of building a tree. Each file holds only its current and next line in memory. Any file found to be
+ * unsorted (or not a word list) sends the whole run back to the tree.
+ */
+
+//One input file of a merge and the word it is currently on.
+typedef struct MergeStream {
+	FILE *file;
+	char *word;
+	size_t wordCapacity;
+	char *next; //Buffer the following line is read into, so it can be checked against "word" before they are swapped.
+	size_t nextCapacity;
+} mergeStream;
+
+//Moves "stream" on to its next word. Returns 1 if there was one, 0 at the end of the file, or -1 if the file isn't a sorted word list.
+int mergeAdvance(mergeStream *stream, int first) {
+	ssize_t length = 0;
+	char *swap = NULL;
+	size_t swapCapacity = 0;
+
+	do {
+		length = getline(&stream->next, &stream->nextCapacity, stream->file);
+
+		if (length < 0) {
+			return 0;
+		}
+
+		if (length > 0 && stream->next[length - 1] == '\n') {
+			stream->next[--length] = '\0';
+		}
+	} while (length == 0);
+
+	if ((ssize_t) strspn(stream->next, "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ") != length) {
+		return -1;
+	}
+
+	if (!first && strcmp(stream->word, stream->next) > 0) {
+		return -1;
+	}
+
+	swap = stream->word;
+	swapCapacity = stream->wordCapacity;
+	stream->word = stream->next;
+	stream->wordCapacity = stream->nextCapacity;
+	stream->next = swap;
+	stream->nextCapacity = swapCapacity;
+
+	return 1;
+}
+
+//Restores the heap order of "heap" below position "i", where the heap holds "count" streams ordered by their current words.
+void mergeSiftDown(mergeStream **heap, int count, int i) {
+	mergeStream *swap = NULL;
+	int smallest = i;
+
+	while (1) {
+		if (2 * i + 1 < count && strcmp(heap[2 * i + 1]->word, heap[smallest]->word) < 0) {
+			smallest = 2 * i + 1;
+		}
+
+		if (2 * i + 2 < count && strcmp(heap[2 * i + 2]->word, heap[smallest]->word) < 0) {
+			smallest = 2 * i + 2;
+		}
+
+		if (smallest == i) {
+			return;
+		}
+
+		swap = heap[i];
+		heap[i] = heap[smallest];
+		heap[smallest] = swap;
+		i = smallest;
+	}
+}
+
+//Merges the sorted word lists "paths" into "out", leaving out duplicates. Returns 0 on success, 1 if an input isn't sorted, or -1 on error.
+int mergeWords(char **paths, int count, FILE *out) {
+	mergeStream *streams = calloc(count, sizeof(mergeStream));
+	mergeStream **heap = malloc(count * sizeof(mergeStream *));
+	char *last = NULL;
+	size_t lastCapacity = 0
+              ,length = 0;
+	int live = 0
+           ,result = 0
+           ,status = 0
+           ,i = 0;
+
+	for (i = 0; i < count && result == 0; i++) {
+		streams[i].file = fopen(paths[i], "r");
+
+		if (streams[i].file == NULL) {
+			printf("Could not open %s.\n", paths[i]);
+			result = -1;
+		} else {
+			status = mergeAdvance(&streams[i], 1);
+
+			if (status < 0) {
+				result = 1;
+			} else if (status > 0) {
+				heap[live++] = &streams[i];
+			}
+		}
+	}
+
+	for (i = live / 2 - 1; i >= 0; i--) {
+		mergeSiftDown(heap, live, i);
+	}
+
+	while (result == 0 && live > 0) {
+		//Equal words from different files come off the heap one after another, so comparing with the last word written is enough to dedupe.
+		if (last == NULL || strcmp(last, heap[0]->word) != 0) {
+			fprintf(out, "%s\n", heap[0]->word);
+			length = strlen(heap[0]->word) + 1;
+
+			if (length > lastCapacity) {
+				lastCapacity = length * 2;
+				last = realloc(last, lastCapacity);
+			}
+
+			memcpy(last, heap[0]->word, length);
+		}
+
+		status = mergeAdvance(heap[0], 0);
+
+		if (status < 0) {
+			result = 1;
+		} else if (status == 0) {
+			heap[0] = heap[--live];
+		}
+
+		mergeSiftDown(heap, live, 0);
+	}
+
+	for (i = 0; i < count; i++) {
+		if (streams[i].file != NULL) {
+			fclose(streams[i].file);
+		}
+
+		free(streams[i].word);
+		free(streams[i].next);
+	}
+
+	free(last);
+	free(heap);
+	free(streams);
+
+	return result;
+}
+
+//Tokenizes the files "paths" into the tree with root node "root" the usual way, for inputs that turned out not to be sorted. Returns the new root.
+node* mergeFallback(char **paths, int count, node *root) {
+	wordStream stream;
+	char buffer[65536];
+	ssize_t length = 0;
+	int fd = 0
+           ,i = 0;
+
+	for (i = 0; i < count; i++) {
+		fd = open(paths[i], O_RDONLY);
+
+		if (fd < 0) {
+			continue;
+		}
+
+		streamInit(&stream, insertVisitor, &root);
+
+		while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+			streamFeed(&stream, buffer, length);
+		}
+
+		streamFinish(&stream);
+		close(fd);
+	}
+
+	return root;
+}
+
+/*
+ * Prints the merge of the sorted word lists "paths". Merged words are spooled to a temporary file and only copied out once the merge has succeeded,
+ * so nothing reaches standard output if the tree turns out to be needed after all. Returns 0 on success or -1 on error.
+ */
+int merge(char **paths, int count) {
+	node *root = NULL;
+	FILE *out = tmpfile();
+	int result = 0;
+
+	if (out == NULL) {
+		return -1;
+	}
+
+	result = mergeWords(paths, count, out);
+
+	if (result == 1) {
+		root = mergeFallback(paths, count, root);
+		printTree(root);
+		recycleTree(root);
+		result = 0;
+	} else if (result == 0) {
+		result = fflush(out) == 0 ? 0 : -1;
+		rewind(out);
+
+		if (result == 0) {
+			result = copyStream(fileno(out), STDOUT_FILENO);
+		}
+	}
+
+	fclose(out);
+
+	return result;
+}
+
+/*
+ * Result cache. Output is stored in the cache directory under a hash of the input and the options, so running again on the same input with the same
+ * options serves the stored bytes with sendfile instead of sorting anything. A file given with --input is part of the input, so its decompressed
+ * bytes are hashed into the key too; a changed file is a miss even if its name, size and modification time are the same. Each stored result starts with the full header it was keyed on, and a
+ * hit is only served if that header matches, so neither a hash collision nor a rebuilt binary can serve someone else's output. Serving a file
+ * touches it, and the least recently touched files are evicted once the directory grows past its size limit.
+ */
+
+#define CACHE_SIZE (64 << 20)
+
+//Changes whenever the layout of stored results changes, so older entries stop matching.
+#define CACHE_FORMAT "pointersorter-cache 2"
+
+//Running FNV-1a hash and length of the decompressed bytes of an --input file.
+typedef struct InputDigest {
+	uint64_t hash;
+	unsigned long long length;
+} inputDigest;
+
+//Input consumer which folds each block into the inputDigest pointed to by "context".
+void digestConsumer(char *bytes, int length, void *context) {
+	inputDigest *digest = context;
+	int i = 0;
+
+	for (i = 0; i < length; i++) {
+		digest->hash ^= (unsigned char) bytes[i];
+		digest->hash *= 0x100000001b3ULL;
+	}
+
+	digest->length += length;
+}
+
+//Describes one stored result for eviction.
+typedef struct CacheEntry {
+	char name[32];
+	time_t touched;
+	off_t size;
+} cacheEntry;
+
+//Returns 1 if argument "i" is one of the cache options, which don't change the output and so aren't part of the key.
+int isCacheOption(int argc, char **argv, int i) {
+	return (strcmp(argv[i], "--cache-dir") == 0 || strcmp(argv[i], "--cache-size") == 0) && i + 1 < argc;
+}
+
+/*
+ * Builds the header a stored result for these arguments starts with: a line with the cache format, this binary's modification time and size and the
+ * number of arguments, then every argument except the cache options with its terminator, and then a line with the hash and length of the
+ * decompressed "inputPath" if it isn't NULL. The key is a hash of the header. Returns the header and its length in "length", or NULL if the binary
+ * can't be identified or the input can't be read.
+ */
+char* cacheHeader(int argc, char **argv, char *inputPath, size_t *length) {
+	struct stat binary;
+	inputDigest digest = {0xcbf29ce484222325ULL, 0};
+	char *header = NULL;
+	size_t used = 0
+              ,size = 0;
+	int kept = 0
+           ,i = 0;
+
+	if (stat("/proc/self/exe", &binary) != 0) {
+		return NULL;
+	}
+
+	if (inputPath != NULL && readInput(inputPath, digestConsumer, &digest) != 0) {
+		return NULL;
+	}
+
+	for (i = 1; i < argc; i++) {
+		if (isCacheOption(argc, argv, i)) {
+			i++;
+			continue;
+		}
+
+		size += strlen(argv[i]) + 1;
+		kept++;
+	}
+
+	//The argument count is in the first line so that one argument list can't be a prefix of another.
+	header = malloc(size + 192);
+	used = snprintf(header, 128, "%s %lld.%09ld %lld %d\n", CACHE_FORMAT, (long long) binary.st_mtim.tv_sec, binary.st_mtim.tv_nsec,
+	                (long long) binary.st_size, kept);
+
+	for (i = 1; i < argc; i++) {
+		if (isCacheOption(argc, argv, i)) {
+			i++;
+			continue;
+		}
+
+		memcpy(header + used, argv[i], strlen(argv[i]) + 1);
+		used += strlen(argv[i]) + 1;
+	}
+
+	if (inputPath != NULL) {
+		used += snprintf(header + used, 64, "input %016llx %llu\n", (unsigned long long) digest.hash, digest.length);
+	}
+
+	*length = used;
+
+	return header;
+}
+
+//Copies "fd" from "offset" to the end to standard output, with sendfile where the kernel allows it. Returns 0 on success or -1 on error.
+int cacheCopy(int fd, off_t offset) {
+	struct stat info;
+	ssize_t sent = 0;
+
+	if (fstat(fd, &info) != 0) {
+		return -1;
+	}
+
+	while (offset < info.st_size) {
+		sent = sendfile(STDOUT_FILENO, fd, &offset, info.st_size - offset);
+
+		if (sent < 0 && errno == EINTR) {
+			continue;
+		}
+
+		//Some outputs, like files opened for appending, can't take sendfile, so copy the rest by hand.
+		if (sent < 0 && (errno == EINVAL || errno == ENOSYS)) {
+			lseek(fd, offset, SEEK_SET);
+			return copyStream(fd, STDOUT_FILENO);
+		}
+
+		if (sent <= 0) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Serves the stored result "path" to standard output and marks it as recently used, if it starts with "header". Returns 0 on success or -1 if there
+ * is no stored result for this header.
+ */
+int cacheServe(char *path, char *header, size_t length) {
+	char *stored = NULL;
+	int fd = open(path, O_RDONLY)
+           ,result = 0;
+
+	if (fd < 0) {
+		return -1;
+	}
+
+	//A result stored for other arguments or another build that happens to share the key is a miss, and gets replaced.
+	stored = malloc(length);
+
+	if (pread(fd, stored, length, 0) != (ssize_t) length || memcmp(stored, header, length) != 0) {
+		free(stored);
+		close(fd);
+		return -1;
+	}
+
+	free(stored);
+	futimens(fd, NULL);
+	result = cacheCopy(fd, length);
+	close(fd);
+
+	return result;
+}
+
+//Sorts cache entries oldest first.
+int compareCacheEntries(const void *a, const void *b) {
+	const cacheEntry *x = a
+                        ,*y = b;
+
+	return (x->touched > y->touched) - (x->touched < y->touched);
+}
+
+//Deletes the least recently used results in "dir" until the rest fit in "limit" bytes.
+void cacheEvict(char *dir, size_t limit) {
+	DIR *listing = opendir(dir);
+	struct dirent *file = NULL;
+	struct stat info;
+	cacheEntry *entries = NULL;
+	char path[4096];
+	size_t total = 0;
+	int count = 0
+           ,capacity = 0
+           ,i = 0;
+
+	if (listing == NULL) {
+		return;
+	}
+
+	while ((file = readdir(listing)) != NULL) {
+		//Stored results are named by their 16 hex digit key. Everything else, including results still being written, is left alone.
+		if (strlen(file->d_name) != 16 || strspn(file->d_name, "0123456789abcdef") != 16) {
+			continue;
+		}
+
+		snprintf(path, sizeof(path), "%s/%s", dir, file->d_name);
+
+		if (stat(path, &info) != 0 || !S_ISREG(info.st_mode)) {
+			continue;
+		}
+
+		if (count == capacity) {
+			capacity = capacity == 0 ? 64 : capacity * 2;
+			entries = realloc(entries, capacity * sizeof(cacheEntry));
+		}
+
+		strcpy(entries[count].name, file->d_name);
+		entries[count].touched = info.st_mtime;
+		entries[count].size = info.st_size;
+		total += info.st_size;
+		count++;
+	}
+
+	closedir(listing);
+	qsort(entries, count, sizeof(cacheEntry), compareCacheEntries);
+
+	for (i = 0; i < count && total > limit; i++) {
+		snprintf(path, sizeof(path), "%s/%s", dir, entries[i].name);
+
+		if (unlink(path) == 0) {
+			total -= entries[i].size;
+		}
+	}
+
+	free(entries);
+}
+
+/*
+ * Handles a cache miss. The process writes "header" to a temporary file in "dir" and forks, and the child returns 1 to carry on sorting with its
+ * standard output appended to the file. The parent waits for it, moves the temporary file to "path" if the child succeeded, serves it, evicts down
+ * to "limit" and returns 0 with the child's result in "result". If the cache can't be used at all, 1 is returned without forking and the caller
+ * just sorts as usual.
+ */
+int cacheFill(char *dir, char *path, char *header, size_t length, size_t limit, int *result) {
+	char temporary[4096];
+	pid_t child = 0;
+	int fd = 0
+           ,status = 0;
+
+	snprintf(temporary, sizeof(temporary), "%s/.pointersorter-XXXXXX", dir);
+	fd = mkstemp(temporary);
+
+	if (fd < 0) {
+		return 1;
+	}
+
+	if (writeAll(fd, header, length, -1) != 0) {
+		close(fd);
+		unlink(temporary);
+		return 1;
+	}
+
+	//mkstemp makes the file private, but other runs should be able to read the result.
+	fchmod(fd, 0644);
+	fflush(stdout);
+	child = fork();
+
+	if (child < 0) {
+		close(fd);
+		unlink(temporary);
+		return 1;
+	}
+
+	if (child == 0) {
+		dup2(fd, STDOUT_FILENO);
+		close(fd);
+		return 1;
+	}
+
+	while (waitpid(child, &status, 0) < 0 && errno == EINTR) {
+	}
+
+	//Failed runs still show their output, but it isn't kept.
+	if (WIFEXITED(status) && WEXITSTATUS(status) == 0 && rename(temporary, path) == 0) {
+		*result = cacheCopy(fd, length);
+		cacheEvict(dir, limit);
+	} else {
+		*result = -1;
+		cacheCopy(fd, length);
+		unlink(temporary);
+	}
+
+	close(fd);
+
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	node *root = NULL
+            ,*anagramTree = NULL;
+	frozenHeader *frozen = NULL;
+	wordList checked = {NULL, 0, 0}
+                ,tokens = {NULL, 0, 0};
+	slidingWindow window = {0};
+	shardedTree sharded;
+	dedupeSet deduped;
+	dawg automaton;
+	loudsTrie trie;
+	twoTier tiers = {NULL, NULL};
+	oldVocabulary old;
+	perfectHash userStopwords;
+	stopwordFilter filter = {NULL, NULL, NULL};
+	inputBuffer slurped = {NULL, 0, 0};
+	wordStream inputStream;
+	size_t inputLength = 0
+              ,cacheSize = CACHE_SIZE
+              ,cacheHeaderLength = 0;
+	long long parsed = 0;
+	prefixTree prefixed = {NULL, {NULL, NULL}, 0};
+	void (*visit)(char *word, int wordLength, void *context) = NULL;
+	void *context = NULL;
+	void *mapped = NULL;
+	size_t frozenLength = 0
+              ,mappedLength = 0;
+	char *found = NULL
+            ,*input = NULL
+            ,*outPrefix = NULL
+            ,*workers = NULL
+            ,*shmName = NULL
+            ,*shmCheck = NULL
+            ,*check = NULL
+            ,*dawgPath = NULL
+            ,*dawgPrefixPath = NULL
+            ,*dawgQueryPath = NULL
+            ,*loudsPath = NULL
+            ,*loudsQueryPath = NULL
+            ,*loudsListPath = NULL
+            ,*freezePath = NULL
+            ,*basePath = NULL
+            ,*diffPath = NULL
+            ,*followPath = NULL
+            ,*snapshotPath = NULL
+            ,*cacheDir = NULL
+            ,*inputPath = NULL
+            ,*cacheHeaderBytes = NULL
+            ,*end = NULL
+            ,cachePath[4096]
+            ,**words = NULL
+            ,**mergePaths = NULL;
+	int threads = 1
+           ,shards = 0
+           ,insertThreads = 1
+           ,dedupeThreads = 1
+           ,sharding = 0
+           ,deduping = 0
+           ,runs = 0
+           ,running = 0
+           ,prefixKeys = 0
+           ,prefixing = 0
+           ,windowSize = 0
+           ,tumbling = 0
+           ,ngram = 0
+           ,anagrams = 0
+           ,interval = 0
+           ,mergeCount = 0
+           ,extra = 0
+           ,count = 0
+           ,result = 0
+           ,i = 0;
+
+	//Options come before or after the input string. Anything else left over is an error which will be caught by the conditional below.
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			threads = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--insert-threads") == 0 && i + 1 < argc) {
+			insertThreads = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--dedupe-threads") == 0 && i + 1 < argc) {
+			dedupeThreads = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--shards") == 0 && i + 1 < argc) {
+			shards = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--out-prefix") == 0 && i + 1 < argc) {
+			outPrefix = argv[++i];
+		} else if (strcmp(argv[i], "--worker") == 0 && i + 1 < argc) {
+			return work(argv[++i]);
+		} else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+			workers = argv[++i];
+		} else if (strcmp(argv[i], "--shm") == 0 && i + 1 < argc) {
+			shmName = argv[++i];
+		} else if (strcmp(argv[i], "--shm-check") == 0 && i + 1 < argc) {
+			shmCheck = argv[++i];
+		} else if (strcmp(argv[i], "--check") == 0 && i + 1 < argc) {
+			check = argv[++i];
+		} else if (strcmp(argv[i], "--window") == 0 && i + 1 < argc) {
+			windowSize = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--stopwords") == 0) {
+			filter.stopwords = &builtinStopwordHash;
+		} else if (strcmp(argv[i], "--stopword-file") == 0 && i + 1 < argc) {
+			if (loadStopwords(&userStopwords, argv[++i]) != 0) {
+				printf("Could not read stop words from %s.\n", argv[i]);
+				return -1;
+			}
+
+			filter.stopwords = &userStopwords;
+		} else if (strcmp(argv[i], "--emit-stopwords") == 0) {
+			return emitStopwordTables();
+		} else if (strcmp(argv[i], "--follow") == 0 && i + 1 < argc) {
+			followPath = argv[++i];
+		} else if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc) {
+			interval = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc) {
+			snapshotPath = argv[++i];
+		} else if (strcmp(argv[i], "--cache-dir") == 0 && i + 1 < argc) {
+			cacheDir = argv[++i];
+		} else if (strcmp(argv[i], "--cache-size") == 0 && i + 1 < argc) {
+			errno = 0;
+			parsed = strtoll(argv[++i], &end, 10);
+
+			if (end == argv[i] || *end != '\0' || errno != 0 || parsed < 0) {
+				printf("Invalid --cache-size %s.\n", argv[i]);
+				return -1;
+			}
+
+			cacheSize = parsed;
+		} else if (strcmp(argv[i], "--merge") == 0 && i + 1 < argc) {
+			//--merge is given once per file to merge.
+			if (mergePaths == NULL) {
+				mergePaths = malloc(argc * sizeof(char *));
+			}
+
+			mergePaths[mergeCount++] = argv[++i];
+		} else if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+			inputPath = argv[++i];
+		} else if (strcmp(argv[i], "--prefix-keys") == 0) {
+			prefixKeys = 1;
+		} else if (strcmp(argv[i], "--runs") == 0) {
+			runs = 1;
+		} else if (strcmp(argv[i], "--anagrams") == 0) {
+			anagrams = 1;
+		} else if (strcmp(argv[i], "--ngram") == 0 && i + 1 < argc) {
+			ngram = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--tumbling") == 0 && i + 1 < argc) {
+			tumbling = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--dawg") == 0 && i + 1 < argc) {
+			dawgPath = argv[++i];
+		} else if (strcmp(argv[i], "--dawg-prefix") == 0 && i + 1 < argc) {
+			dawgPrefixPath = argv[++i];
+		} else if (strcmp(argv[i], "--dawg-query") == 0 && i + 1 < argc) {
+			dawgQueryPath = argv[++i];
+		} else if (strcmp(argv[i], "--louds") == 0 && i + 1 < argc) {
+			loudsPath = argv[++i];
+		} else if (strcmp(argv[i], "--louds-query") == 0 && i + 1 < argc) {
+			loudsQueryPath = argv[++i];
+		} else if (strcmp(argv[i], "--louds-list") == 0 && i + 1 < argc) {
+			loudsListPath = argv[++i];
+		} else if (strcmp(argv[i], "--freeze") == 0 && i + 1 < argc) {
+			freezePath = argv[++i];
+		} else if (strcmp(argv[i], "--base") == 0 && i + 1 < argc) {
+			basePath = argv[++i];
+		} else if (strcmp(argv[i], "--diff-against") == 0 && i + 1 < argc) {
+			diffPath = argv[++i];
+		} else if (input == NULL) {
+			input = argv[i];
+		} else {
+			extra = 1;
+			break;
+		}
+	}
+
+	//Modes that read their words only from somewhere else would ignore an input string, so don't take one.
+	if (input != NULL && (loudsListPath != NULL || followPath != NULL || mergeCount > 0 || tumbling > 0)) {
+		printf("An input string can't be combined with --merge, --tumbling, --follow or --louds-list.\n");
+		return -1;
+	}
+
+	//Modes that read their words from somewhere else can do without the input string.
+	if (input == NULL && (loudsListPath != NULL || followPath != NULL || inputPath != NULL || mergeCount > 0 || tumbling > 0)) {
+		input = "";
+	}
+
+	//Should be exactly one input string.
+	if (input == NULL || extra) {
+		printf("Invalid number of arguments (%d) provided.\n", argc - 1);
+		return -1;
+	}
+
+	//Sharded output needs both a shard count and somewhere to put the shards.
+	if ((shards != 0 || outPrefix != NULL) && (shards < 1 || outPrefix == NULL)) {
+		printf("--shards needs a positive shard count and --out-prefix.\n");
+		return -1;
+	}
+
+	//Each of these replaces how the words are collected, so only one of them can be used at a time.
+	if ((runs != 0) + (prefixKeys != 0) + (insertThreads > 1) + (dedupeThreads > 1) > 1) {
+		printf("Only one of --runs, --prefix-keys, --insert-threads and --dedupe-threads can be given.\n");
+		return -1;
+	}
+	
+//	printf("---START DEBUG INFO---\n");
+
+	/*
+	 * Only runs whose output is all on standard output and depends only on the arguments and the --input file are cached. Anything that reads other
+	 * files or standard input, or writes somewhere else, always runs.
+	 */
+	if (cacheDir != NULL && mergeCount == 0 && tumbling == 0 && followPath == NULL && workers == NULL && shmName == NULL && shmCheck == NULL && shards == 0
+	    && dawgPath == NULL && dawgPrefixPath == NULL && dawgQueryPath == NULL && loudsPath == NULL && loudsQueryPath == NULL && loudsListPath == NULL
+	    && freezePath == NULL && basePath == NULL && diffPath == NULL && (filter.stopwords == NULL || filter.stopwords == &builtinStopwordHash)) {
+		cacheHeaderBytes = cacheHeader(argc, argv, inputPath, &cacheHeaderLength);
+	}
+
+	if (cacheHeaderBytes != NULL) {
+		snprintf(cachePath, sizeof(cachePath), "%s/%016llx", cacheDir, (unsigned long long) hashSeeded(cacheHeaderBytes, cacheHeaderLength, 0));
+
+		if (cacheServe(cachePath, cacheHeaderBytes, cacheHeaderLength) == 0) {
+			return 0;
+		}
+
+		//Misses carry on sorting in a child whose output goes into the cache; the parent stores and serves it.
+		if (!cacheFill(cacheDir, cachePath, cacheHeaderBytes, cacheHeaderLength, cacheSize, &result)) {
+			return result;
+		}
+
+		free(cacheHeaderBytes);
+	}
+
+	//Merge mode reads sorted word lists from files instead of taking an input string.
+	if (mergeCount > 0) {
+		result = merge(mergePaths, mergeCount);
+		free(mergePaths);
+		return result;
+	}
+
+	//Tumbling windows read standard input and tokenize each line themselves, with no stop word filter.
+	if (tumbling > 0 && (filter.stopwords != NULL || inputPath != NULL)) {
+		printf("--tumbling can't be combined with stop words or --input.\n");
+		return -1;
+	}
+
+	//Tumbling-window mode reads timestamped lines from standard input instead of taking an input string.
+	if (tumbling > 0) {
+		return countTumbling(tumbling);
+	}
+
+	//Insertion is split across threads into prefix shards or through the dedupe table if asked to. Modes that walk "root" afterwards can't use the
+	//shards, which never fill it.
+	sharding = insertThreads > 1 && check == NULL && followPath == NULL && diffPath == NULL && !anagrams;
+	deduping = !sharding && dedupeThreads > 1 && followPath == NULL;
+
+	//Modes that need all of the input at once get the --input file read into memory after the input string, and so do the threaded insertions,
+	//which split it between their threads. The plain sort streams it further down.
+	if (inputPath != NULL && (workers != NULL || shmCheck != NULL || dawgPrefixPath != NULL || dawgQueryPath != NULL || loudsQueryPath != NULL || basePath != NULL
+	    || ngram > 0 || windowSize > 0 || sharding || deduping)) {
+		bufferConsumer(input, strlen(input), &slurped);
+		bufferConsumer(" ", 1, &slurped);
+
+		if (readInput(inputPath, bufferConsumer, &slurped) != 0) {
+			printf("Could not read %s.\n", inputPath);
+			return -1;
+		}
+
+		input = slurped.bytes;
+		inputPath = NULL;
+	}
+
+	//Get length of input argument/length of all valid substrings plus delimiters. A slurped file can hold NULs, so its own length is used.
+	inputLength = input == slurped.bytes ? slurped.length : strlen(input);
+
+	//Coordinators never build a tree of their own; the workers own the words.
+	if (workers != NULL) {
+		return coordinate(input, inputLength, workers);
+	}
+
+	//Checking against a published vocabulary only reads the shared segment; nothing is inserted.
+	if (shmCheck != NULL) {
+		frozen = mapShared(shmCheck, &frozenLength);
+
+		if (frozen == NULL) {
+			printf("Could not map shared vocabulary %s.\n", shmCheck);
+			return -1;
+		}
+
+		forEachWord(input, inputLength, frozenCheckVisitor, frozen);
+		munmap(frozen, frozenLength);
+		return 0;
+	}
+
+	if (dawgPrefixPath != NULL && dawgQueryPath != NULL) {
+		printf("--dawg-query can't be combined with --dawg-prefix.\n");
+		return -1;
+	}
+
+	//DAWG queries print whether each input word is in a saved DAWG, and prefix queries print every word in it starting with each input word.
+	if (dawgPrefixPath != NULL || dawgQueryPath != NULL) {
+		mapped = mapFile(dawgQueryPath != NULL ? dawgQueryPath : dawgPrefixPath, &mappedLength);
+
+		if (mapped == NULL || !dawgOpen(&automaton, mapped, mappedLength)) {
+			printf("Could not read DAWG %s.\n", dawgQueryPath != NULL ? dawgQueryPath : dawgPrefixPath);
+			return -1;
+		}
+
+		forEachWord(input, inputLength, dawgQueryPath != NULL ? dawgQueryVisitor : dawgPrefixVisitor, &automaton);
+		munmap(mapped, mappedLength);
+		return 0;
+	}
+
+	//LOUDS queries print, for each input word, whether it is in a saved trie and how many words in the trie start with it. Listing prints the whole trie.
+	if (loudsQueryPath != NULL || loudsListPath != NULL) {
+		mapped = mapFile(loudsQueryPath != NULL ? loudsQueryPath : loudsListPath, &mappedLength);
+
+		if (mapped == NULL || !loudsOpen(&trie, mapped, mappedLength)) {
+			printf("Could not read LOUDS trie %s.\n", loudsQueryPath != NULL ? loudsQueryPath : loudsListPath);
+			return -1;
+		}
+
+		if (loudsQueryPath != NULL) {
+			forEachWord(input, inputLength, loudsQueryVisitor, &trie);
+		} else {
+			loudsEnumerate(&trie, printVisitor, NULL);
+		}
+
+		munmap(mapped, mappedLength);
+		return 0;
+	}
+
+	//With a base dictionary only the words missing from it go into the tree, and the output is the union of the two.
+	if (basePath != NULL) {
+		mapped = mapFile(basePath, &mappedLength);
+
+		if (mapped == NULL || !frozenValid(mapped, mappedLength)) {
+			printf("Could not read base dictionary %s.\n", basePath);
+			return -1;
+		}
+
+		tiers.base = mapped;
+		forEachWordExcept(input, inputLength, filter.stopwords, twoTierVisitor, &tiers);
+		count = countNodes(tiers.delta);
+		words = malloc((count + 1) * sizeof(char *));
+		flattenTree(tiers.delta, words, 0);
+		printMerged(tiers.base, words, count);
+		free(words);
+		recycleTree(tiers.delta);
+		munmap(mapped, mappedLength);
+		return 0;
+	}
+
+	//N-gram mode prints counts of word sequences instead of the sorted words.
+	if (ngram > 0) {
+		return countNgrams(input, inputLength, ngram, filter.stopwords);
+	}
+
+	//Sliding-window mode prints the vocabulary of only the last "windowSize" words, or with --check the words of the --check string missing from it.
+	if (windowSize > 0) {
+		window.ring = malloc(windowSize * sizeof(node *));
+		window.size = windowSize;
+		cuckooInit(&window.filter, 1024);
+		compactorInit(&window.nodes);
+		forEachWordExcept(input, inputLength, filter.stopwords, windowVisitor, &window);
+
+		if (check != NULL) {
+			forEachWord(check, strlen(check), collectVisitor, &checked);
+			windowCheck(&window, checked.words, checked.count);
+			recycleWordList(&checked);
+		} else {
+			printTree(window.root);
+		}
+
+		recycleCompactor(&window.nodes);
+		cuckooFree(&window.filter);
+		free(window.ring);
+		return 0;
+	}
+
+	//Iterate over the input argument, on several threads into prefix shards or through the dedupe table if asked to.
+	//Run detection needs the tokens in input order, and only pays off when the output is the sorted words themselves.
+	running = runs && !sharding && !deduping && check == NULL && !anagrams && diffPath == NULL && followPath == NULL;
+
+	//So does the prefix-keyed set, which only the array output paths know how to read.
+	prefixing = prefixKeys && !running && !sharding && !deduping && check == NULL && !anagrams && diffPath == NULL && followPath == NULL;
+
+	if (prefixing) {
+		filter.visit = prefixVisitor;
+		filter.context = &prefixed;
+	} else if (running) {
+		filter.visit = collectVisitor;
+		filter.context = &tokens;
+	} else if (sharding) {
+		shardedInit(&sharded);
+		filter.visit = shardedVisitor;
+		filter.context = &sharded;
+	} else if (deduping) {
+		dedupeInit(&deduped, 1024);
+		filter.visit = dedupeVisitor;
+		filter.context = &deduped;
+	} else {
+		filter.visit = insertVisitor;
+		filter.context = &root;
+	}
+
+	//Stop words are dropped on the way to whichever visitor does the inserting.
+	if (filter.stopwords != NULL) {
+		visit = stopwordVisitor;
+		context = &filter;
+	} else {
+		visit = filter.visit;
+		context = filter.context;
+	}
+
+	//Follow mode keeps inserting into the tree for as long as the file is being written to.
+	if (followPath != NULL) {
+		result = follow(followPath, interval, snapshotPath, visit, context, &root);
+		recycleTree(root);
+		return result;
+	}
+
+	//A file given with --input is tokenized block by block while the reader thread decompresses the next ones, along with the input string.
+	if (inputPath != NULL) {
+		streamInit(&inputStream, visit, context);
+		result = readInput(inputPath, streamConsumer, &inputStream);
+		streamFinish(&inputStream);
+
+		if (result != 0) {
+			printf("Could not read %s.\n", inputPath);
+			return -1;
+		}
+	}
+
+	if (sharding) {
+		forEachWordParallel(input, inputLength, insertThreads, visit, context);
+		count = shardedCount(&sharded);
+		words = malloc((count + 1) * sizeof(char *));
+		flattenSharded(&sharded, words);
+	} else if (deduping) {
+		//Deduplicate on every thread first, so the single-threaded tree only ever sees each word once.
+		forEachWordParallel(input, inputLength, dedupeThreads, visit, context);
+		root = insertDeduped(root, &deduped);
+	} else {
+		forEachWord(input, inputLength, visit, context);
+	}
+
+	if (running) {
+		words = sortRuns(&tokens, &root, &count);
+	} else if (prefixing) {
+		words = flattenPrefixTree(&prefixed);
+		count = prefixed.count;
+	}
+
+	//Spell-check mode prints the words of the --check string which are not in the input, instead of the sorted input.
+	if (check != NULL) {
+		forEachWord(check, strlen(check), collectVisitor, &checked);
+		found = malloc(checked.count + 1);
+		containsBatch(root, checked.words, checked.count, found);
+
+		for (i = 0; i < checked.count; i++) {
+			if (!found[i]) {
+				printf("%s\n", checked.words[i]);
+			}
+		}
+
+		free(found);
+		recycleWordList(&checked);
+		recycleTree(root);
+		return 0;
+	}
+
+//	printf("---END DEBUG INFO---\n");
+
+	//Anagram mode prints the words grouped into anagram classes instead of one per line.
+	if (anagrams) {
+		anagramTree = buildAnagrams(root);
+		printAnagrams(anagramTree);
+		recycleAnagrams(anagramTree);
+		recycleTree(root);
+		return 0;
+	}
+
+	//Diff mode prints only what changed since an earlier run's output, instead of the sorted input.
+	if (diffPath != NULL) {
+		if (openOldVocabulary(&old, diffPath) != 0) {
+			printf("Could not read earlier output %s.\n", diffPath);
+			return -1;
+		}
+
+		printDiff(root, &old);
+		closeOldVocabulary(&old);
+		recycleTree(root);
+		return 0;
+	}
+
+	//Output to a regular file or a pipe goes through printMapped or printSpliced, which need the words in an array too.
+	if (words == NULL && (isRegularFile(STDOUT_FILENO) || isPipe(STDOUT_FILENO) || shards > 0 || threads > 1 || shmName != NULL || dawgPath != NULL || loudsPath != NULL || freezePath != NULL)) {
+		count = countNodes(root);
+		words = malloc((count + 1) * sizeof(char *));
+		flattenTree(root, words, 0);
+	}
+
+	//Every file output asked for is written. Standard output only gets the words when none was.
+	if (words != NULL) {
+		if (freezePath != NULL && writeFrozen(freezePath, words, count) != 0) {
+			printf("Could not write frozen vocabulary %s.\n", freezePath);
+			result = -1;
+		}
+
+		if (loudsPath != NULL && writeLouds(loudsPath, words, count) != 0) {
+			printf("Could not write LOUDS trie %s.\n", loudsPath);
+			result = -1;
+		}
+
+		if (dawgPath != NULL && writeDawg(dawgPath, words, count) != 0) {
+			printf("Could not write DAWG %s.\n", dawgPath);
+			result = -1;
+		}
+
+		if (shmName != NULL && publishShared(shmName, words, count) != 0) {
+			printf("Could not publish shared vocabulary %s.\n", shmName);
+			result = -1;
+		}
+
+		if (shards > 0 && writeShards(words, count, shards, outPrefix) != 0) {
+			result = -1;
+		}
+
+		if (freezePath == NULL && loudsPath == NULL && dawgPath == NULL && shmName == NULL && shards == 0) {
+			//Pipes get the output spliced and regular files get it mapped. Anything else, or anything those can't handle, gets it written.
+			result = printSpliced(words, count, threads, STDOUT_FILENO);
+
+			if (result > 0) {
+				result = printMapped(words, count, threads, STDOUT_FILENO);
+			}
+
+			if (result > 0) {
+				result = printParallel(words, count, threads, STDOUT_FILENO);
+			}
+		}
+
+		free(words);
+	} else {
+		printTree(root);
+	}
+
+	if (sharding) {
+		recycleSharded(&sharded);
+	}
+
+	recycleTree(root);
+
+	if (running) {
+		recycleWordList(&tokens);
+	}
+
+	if (prefixing) {
+		recycleBump(&prefixed.arena);
+	}
+
+	if (deduping) {
+		recycleDedupe(&deduped);
+	}
+
+	return result;
+}
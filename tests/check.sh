@@ -0,0 +1,59 @@
+#!/bin/sh
+#Runs each mode of pointersorter against known-good output. Plain sorts are checked against sort -u over the same words, and the rest against
+#small hand-checked cases. Each mode's checks are in their own script in tests/modes, which is run with the helpers and corpus set up here.
+#Usage: tests/check.sh [path to pointersorter]
+
+program=${1:-./pointersorter}
+work=$(mktemp -d)
+failures=0
+
+trap 'rm -rf "$work"' EXIT
+export LC_ALL=C
+
+#Reports the test "$1" as passed if "$work/actual" matches "$work/expected", or as failed with the difference.
+check() {
+	if cmp -s "$work/expected" "$work/actual"; then
+		echo "PASS $1"
+	else
+		echo "FAIL $1"
+		diff "$work/expected" "$work/actual" | head -10
+		failures=$((failures + 1))
+	fi
+}
+
+#Writes "$1" to "$work/expected", one argument per line.
+expect() {
+	printf '%s\n' "$@" > "$work/expected"
+}
+
+#A fixed pseudo-random corpus of short lowercase words, so there are plenty of repeats. It stays under the kernel's limit for one argument.
+awk 'BEGIN {
+	seed = 12345;
+	for (i = 0; i < 15000; i++) {
+		seed = (seed * 1103515245 + 12345) % 2147483648;
+		size = 1 + int(seed / 65536) % 6;
+		word = "";
+		for (j = 0; j < size; j++) {
+			seed = (seed * 1103515245 + 12345) % 2147483648;
+			word = word substr("abcdefghij", 1 + int(seed / 65536) % 10, 1);
+		}
+		printf "%s%s", word, (i % 12 == 11 ? "\n" : " ");
+	}
+}' > "$work/corpus"
+corpus=$(cat "$work/corpus")
+tr -cs 'a-z' '\n' < "$work/corpus" | sed '/^$/d' > "$work/tokens"
+sort -u "$work/tokens" > "$work/sorted"
+
+if [ ! -s "$work/sorted" ]; then
+	echo "Could not generate the test corpus."
+	exit 1
+fi
+
+for script in "$(dirname "$0")"/modes/*.sh; do
+	. "$script"
+done
+
+if [ "$failures" -ne 0 ]; then
+	echo "$failures failed"
+	exit 1
+fi
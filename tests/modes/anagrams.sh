@@ -0,0 +1,4 @@
+#Anagram groups, one per line.
+expect "dog god" "opts post pots spot stop tops"
+"$program" --anagrams "stop pots tops post spot opts dog god" > "$work/actual"
+check "--anagrams"
@@ -0,0 +1,5 @@
+#A frozen base dictionary, with new words in a tree beside it.
+"$program" --freeze "$work/base" "car cat dog" > /dev/null
+expect "apple" "car" "cat" "dog" "zebra"
+"$program" --base "$work/base" "cat zebra apple dog" > "$work/actual"
+check "--base"
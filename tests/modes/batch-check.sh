@@ -0,0 +1,4 @@
+#Words missing from the input, looked up in batches with interleaved descents.
+expect "cat" "zebra"
+"$program" --check "fox cat dog zebra" "the quick brown fox jumps over the lazy dog" > "$work/actual"
+check "--check"
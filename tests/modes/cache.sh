@@ -0,0 +1,18 @@
+#Cached results, served on the second run.
+cp "$work/sorted" "$work/expected"
+mkdir "$work/cache"
+"$program" --cache-dir "$work/cache" "$corpus" > /dev/null
+"$program" --cache-dir "$work/cache" "$corpus" > "$work/actual"
+check "--cache-dir"
+
+#An --input file is keyed on its bytes, so rewriting it with the same size and modification time is still a miss.
+cp "$work/corpus" "$work/cached"
+"$program" --cache-dir "$work/cache" --input "$work/cached" > /dev/null
+"$program" --cache-dir "$work/cache" --input "$work/cached" > "$work/actual"
+check "--cache-dir --input"
+tr 'a' 'k' < "$work/corpus" > "$work/rewritten"
+cat "$work/rewritten" > "$work/cached"
+touch -r "$work/corpus" "$work/cached"
+tr -cs 'a-z' '\n' < "$work/rewritten" | sed '/^$/d' | sort -u > "$work/expected"
+"$program" --cache-dir "$work/cache" --input "$work/cached" > "$work/actual"
+check "--cache-dir --input rewritten"
@@ -0,0 +1,4 @@
+#A sliding window big enough that its nodes are compacted along the way.
+tail -n 5000 "$work/tokens" | sort -u > "$work/expected"
+"$program" --window 5000 --input "$work/corpus" > "$work/actual"
+check "--window"
@@ -0,0 +1,10 @@
+#DAWGs, searched by prefix.
+"$program" --dawg "$work/dawg" "$corpus" > /dev/null
+grep -e '^ab' -e '^j' "$work/sorted" > "$work/expected"
+"$program" --dawg-prefix "$work/dawg" "ab j" > "$work/actual"
+check "--dawg-prefix"
+
+#Exact lookups of every word, and of words one letter longer, which the corpus can't have.
+head -n 500 "$work/sorted" | awk '{ print $0 " 1"; print $0 "k 0" }' > "$work/expected"
+"$program" --dawg-query "$work/dawg" "$(head -n 500 "$work/sorted" | awk '{ print $0; print $0 "k" }')" > "$work/actual"
+check "--dawg-query"
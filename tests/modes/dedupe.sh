@@ -0,0 +1,4 @@
+#Words deduplicated in the concurrent hash table from several threads.
+cp "$work/sorted" "$work/expected"
+"$program" --dedupe-threads 4 "$corpus" > "$work/actual"
+check "--dedupe-threads"
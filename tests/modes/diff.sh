@@ -0,0 +1,15 @@
+#Changes against earlier output.
+"$program" "cat dog" > "$work/old"
+expect "-dog" "+emu"
+"$program" --diff-against "$work/old" "cat emu" > "$work/actual"
+check "--diff-against"
+
+#Earlier output frozen with --freeze, and text that starts with the same bytes as the frozen magic.
+"$program" --freeze "$work/old.frozen" "cat dog" > /dev/null
+expect "-dog" "+emu"
+"$program" --diff-against "$work/old.frozen" "cat emu" > "$work/actual"
+check "--diff-against frozen"
+printf 'rosp\nzebra\n' > "$work/old"
+expect "+yak" "-zebra"
+"$program" --diff-against "$work/old" "rosp yak" > "$work/actual"
+check "--diff-against text like the magic"
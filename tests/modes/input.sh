@@ -0,0 +1,33 @@
+#The same words read from a file, plain and gzipped.
+gzip -c "$work/corpus" > "$work/corpus.gz"
+cp "$work/sorted" "$work/expected"
+"$program" --input "$work/corpus" > "$work/actual"
+check "--input"
+"$program" --input "$work/corpus.gz" > "$work/actual"
+check "--input gzip"
+
+#The threaded insertions split a file between their threads the same way as an input string.
+for threads in "--insert-threads 4" "--dedupe-threads 4"; do
+	"$program" $threads --input "$work/corpus.gz" > "$work/actual"
+	check "--input $threads"
+done
+
+#A zstd file cut off mid-frame is an error, not a shorter input. Builds without libzstd can't read zstd files at all.
+if command -v zstd > /dev/null; then
+	zstd -q -c "$work/corpus" > "$work/corpus.zst"
+
+	if "$program" --input "$work/corpus.zst" > "$work/actual"; then
+		check "--input zstd"
+	fi
+
+	head -c 100 "$work/corpus.zst" > "$work/truncated.zst"
+	: > "$work/expected"
+
+	if "$program" --input "$work/truncated.zst" > /dev/null; then
+		echo "exit 0" > "$work/actual"
+	else
+		: > "$work/actual"
+	fi
+
+	check "--input truncated zstd"
+fi
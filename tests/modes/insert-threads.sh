@@ -0,0 +1,4 @@
+#Words inserted into prefix-sharded trees from several threads.
+cp "$work/sorted" "$work/expected"
+"$program" --insert-threads 4 "$corpus" > "$work/actual"
+check "--insert-threads"
@@ -0,0 +1,9 @@
+#LOUDS tries, listed back and queried.
+"$program" --louds "$work/louds" "$corpus" > /dev/null
+cp "$work/sorted" "$work/expected"
+"$program" --louds-list "$work/louds" > "$work/actual"
+check "--louds-list"
+"$program" --louds "$work/small.louds" "car cart carbon cat dog dot do" > /dev/null
+expect "cat 1 1" "cow 0 0" "do 1 3" "dots 0 0"
+"$program" --louds-query "$work/small.louds" "cat cow do dots" > "$work/actual"
+check "--louds-query"
@@ -0,0 +1,8 @@
+#Output to a regular file goes through a shared mapping, and is appended after anything already there.
+cp "$work/sorted" "$work/expected"
+"$program" "$corpus" > "$work/actual"
+check "mapped output"
+printf 'first\n' > "$work/actual"
+printf 'first\n' | cat - "$work/sorted" > "$work/expected"
+"$program" "$corpus" >> "$work/actual"
+check "mapped output appended"
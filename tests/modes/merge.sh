@@ -0,0 +1,6 @@
+#Merging sorted lists, which overlap.
+head -n 3000 "$work/sorted" > "$work/first"
+tail -n +2000 "$work/sorted" > "$work/second"
+cp "$work/sorted" "$work/expected"
+"$program" --merge "$work/first" --merge "$work/second" > "$work/actual"
+check "--merge"
@@ -0,0 +1,9 @@
+#Bigram counts over interned word IDs.
+awk 'NR > 1 { print previous " " $0 } { previous = $0 }' "$work/tokens" | sort | uniq -c | awk '{ print $2 " " $3 " " $1 }' > "$work/expected"
+"$program" --ngram 2 --input "$work/corpus" > "$work/actual"
+check "--ngram"
+
+#A dropped stop word breaks the n-gram, so words on either side of it never pair up.
+expect "cat sat 1" "dog ran 1"
+"$program" --ngram 2 --stopwords "cat and the dog ran and the cat sat" > "$work/actual"
+check "--ngram --stopwords"
@@ -0,0 +1,19 @@
+#Every file output asked for in one run is written, and options that would be silently ignored are rejected.
+"$program" --dawg "$work/all.dawg" --louds "$work/all.louds" --shards 2 --out-prefix "$work/all" "$corpus" > /dev/null
+cp "$work/sorted" "$work/expected"
+"$program" --louds-list "$work/all.louds" > "$work/actual"
+check "--louds with --dawg and --shards"
+cat "$work/all0" "$work/all1" > "$work/actual"
+check "--shards with --dawg and --louds"
+grep '^ab' "$work/sorted" > "$work/expected"
+"$program" --dawg-prefix "$work/all.dawg" "ab" > "$work/actual"
+check "--dawg with --louds and --shards"
+
+for options in "--runs --insert-threads 2" "--prefix-keys --dedupe-threads 2" "--merge $work/sorted"; do
+	if "$program" $options "word" > /dev/null; then
+		echo "FAIL $options accepted"
+		failures=$((failures + 1))
+	else
+		echo "PASS $options rejected"
+	fi
+done
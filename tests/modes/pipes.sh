@@ -0,0 +1,4 @@
+#Pipes are written with vmsplice rather than mapped.
+cp "$work/sorted" "$work/expected"
+"$program" --threads 4 "$corpus" | cat > "$work/actual"
+check "sort into a pipe"
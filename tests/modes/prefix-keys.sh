@@ -0,0 +1,4 @@
+#Words keyed by their packed prefix in a set generated by DEFINE_RBSET.
+cp "$work/sorted" "$work/expected"
+"$program" --prefix-keys "$corpus" > "$work/actual"
+check "--prefix-keys"
@@ -0,0 +1,6 @@
+#Natural sorted runs kept out of the tree, on input with long sorted stretches.
+cp "$work/sorted" "$work/expected"
+"$program" --runs "$corpus" > "$work/actual"
+check "--runs"
+"$program" --runs "$(cat "$work/sorted" "$work/tokens")" > "$work/actual"
+check "--runs sorted stretches"
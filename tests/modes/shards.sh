@@ -0,0 +1,5 @@
+#Range-partitioned shards, which together hold the whole sorted output.
+cp "$work/sorted" "$work/expected"
+"$program" --shards 4 --out-prefix "$work/shard" "$corpus" > /dev/null
+cat "$work/shard0" "$work/shard1" "$work/shard2" "$work/shard3" > "$work/actual"
+check "--shards"
@@ -0,0 +1,17 @@
+#Vocabularies published in shared memory, republished, and checked by readers that map the name again. The generation is the 64-bit field
+#after the magic and version words of the header.
+if [ -d /dev/shm ]; then
+	segment="/pointersorter-check-$$"
+	"$program" --shm "$segment" "apple cherry" > /dev/null
+	expect "banana"
+	"$program" --shm-check "$segment" "apple banana" > "$work/actual"
+	check "--shm"
+	"$program" --shm "$segment" "banana date" > /dev/null
+	expect "apple"
+	"$program" --shm-check "$segment" "apple banana" > "$work/actual"
+	check "--shm republished"
+	expect 2
+	od -An -t u8 -j 8 -N 8 "/dev/shm$segment" | tr -d ' ' > "$work/actual"
+	check "--shm generation"
+	rm -f "/dev/shm$segment"
+fi
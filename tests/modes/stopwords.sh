@@ -0,0 +1,19 @@
+#Stop words from a file are looked up in a perfect hash. An empty file removes nothing.
+awk 'NR % 3 == 0' "$work/sorted" > "$work/stopwords"
+grep -vxF -f "$work/stopwords" "$work/sorted" > "$work/expected"
+"$program" --stopword-file "$work/stopwords" "$corpus" > "$work/actual"
+check "--stopword-file"
+: > "$work/empty"
+cp "$work/sorted" "$work/expected"
+"$program" --stopword-file "$work/empty" "$corpus" > "$work/actual"
+check "--stopword-file empty"
+
+#Built-in stop words.
+expect "brown" "dog" "fox" "jumps" "lazy" "quick"
+"$program" --stopwords "the quick brown fox jumps over the lazy dog" > "$work/actual"
+check "--stopwords"
+
+#The checked-in tables must be what --emit-stopwords generates.
+sed -n '/^\/\/Generated by "pointersorter --emit-stopwords"/,/^const perfectHash builtinStopwordHash/p' "$(dirname "$0")/../pointersorter.c" > "$work/expected"
+"$program" --emit-stopwords > "$work/actual"
+check "--emit-stopwords"
@@ -0,0 +1,4 @@
+#Sorted output formatted on several threads and written back in order.
+cp "$work/sorted" "$work/expected"
+"$program" --threads 4 "$corpus" > "$work/actual"
+check "--threads"
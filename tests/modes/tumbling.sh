@@ -0,0 +1,4 @@
+#Tumbling windows over timestamped lines, including ones that aren't.
+expect "# window 0" "a 2" "b 1" "# window 10" "c 1"
+printf '5 b a\nnan x\n-3 y\n7 a\n12 c\n' | "$program" --tumbling 10 > "$work/actual"
+check "--tumbling"
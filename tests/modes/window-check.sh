@@ -0,0 +1,6 @@
+#Words missing from the final window, most of them ruled out by the cuckoo filter: every word of the corpus, and words one letter longer.
+tail -n 5000 "$work/tokens" | sort -u > "$work/window"
+head -n 300 "$work/sorted" | awk '{ print $0 "k" }' > "$work/missing"
+head -n 300 "$work/sorted" | grep -vxF -f "$work/window" | cat - "$work/missing" > "$work/expected"
+"$program" --window 5000 --check "$(head -n 300 "$work/sorted" | cat - "$work/missing")" --input "$work/corpus" > "$work/actual"
+check "--window --check"
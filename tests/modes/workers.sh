@@ -0,0 +1,14 @@
+#A distributed sort over two workers on local ports, which exchange the words of their slices with each other.
+port=$((20000 + $$ % 20000))
+"$program" --worker "$port" > /dev/null &
+first=$!
+"$program" --worker "$((port + 1))" > /dev/null &
+second=$!
+sleep 1
+cp "$work/sorted" "$work/expected"
+"$program" --workers "127.0.0.1:$port,127.0.0.1:$((port + 1))" "$corpus" > "$work/actual"
+check "--workers"
+
+#Workers still waiting because the run failed are stopped rather than left behind.
+kill "$first" "$second" 2> /dev/null
+wait "$first" "$second" 2> /dev/null